@@ -2,8 +2,21 @@ from __future__ import annotations
 
 from ._pyglsim import (
     Entity,
+    StorageMode,
+    ObserverEvent,
+    ComponentMemoryStats,
+    MemoryStats,
+    FieldType,
+    FieldInfo,
+    ComponentType,
+    register_component,
+    find_component_type,
+    get_component_types,
     Registry,
     System,
+    TimingStats,
+    Profiler,
+    Tracer,
     Vec2u,
     Vec2f,
     Vec3u,
@@ -15,10 +28,12 @@ from ._pyglsim import (
     CameraComponent,
     Rigidbody,
     World,
+    WorldBatch,
     GpuContext,
     Window,
     RenderingSystem,
     PhysicsSystem,
+    TransformSystem,
     KeyCode,
     MouseButton,
     EventType,
@@ -44,8 +59,21 @@ __all__ = [
     "__doc__",
     "__version__",
     "Entity",
+    "StorageMode",
+    "ObserverEvent",
+    "ComponentMemoryStats",
+    "MemoryStats",
+    "FieldType",
+    "FieldInfo",
+    "ComponentType",
+    "register_component",
+    "find_component_type",
+    "get_component_types",
     "Registry",
     "System",
+    "TimingStats",
+    "Profiler",
+    "Tracer",
     "Vec2u",
     "Vec2f",
     "Vec3u",
@@ -57,10 +85,12 @@ __all__ = [
     "CameraComponent",
     "Rigidbody",
     "World",
+    "WorldBatch",
     "GpuContext",
     "Window",
     "RenderingSystem",
     "PhysicsSystem",
+    "TransformSystem",
     "KeyCode",
     "MouseButton",
     "EventType",
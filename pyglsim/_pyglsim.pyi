@@ -52,6 +52,108 @@ class Entity:
         """
         ...
 
+class StorageMode(Enum):
+    """Memory layout used by a Registry to store components."""
+
+    POOLED = 0
+    ARCHETYPE = 1
+
+class ObserverEvent(Enum):
+    """Component event an observer is notified about."""
+
+    ADDED = 0
+    REMOVED = 1
+
+class ComponentMemoryStats:
+    """Memory held by the storage of a single component type."""
+
+    component_id: int
+    component_size: int
+    count: int
+    """Number of components stored."""
+    bytes_reserved: int
+    """Bytes allocated for the type, including bookkeeping."""
+    bytes_used: int
+    """Bytes of the reserved ones holding live components."""
+    dense_pages: int
+    """Dense pages, or chunks holding the type in archetype mode."""
+    sparse_pages: int
+    shared_pages: int
+    """Pages still shared copy-on-write with a snapshot."""
+    fragmentation: float
+    """Share of the reserved bytes not holding live components."""
+
+class MemoryStats:
+    """Memory usage of a Registry, see Registry.get_memory_stats()."""
+
+    components: list[ComponentMemoryStats]
+    entity_count: int
+    entity_capacity: int
+    """Entity slots ever created, live or despawned."""
+    free_list_length: int
+    """Despawned entity indices waiting to be reused."""
+    entity_bytes_reserved: int
+    entity_bytes_used: int
+    archetype_count: int
+    bytes_reserved: int
+    bytes_used: int
+    fragmentation: float
+
+class FieldType(Enum):
+    """Value type of a component field."""
+
+    BOOL = 0
+    INT32 = 1
+    UINT32 = 2
+    INT64 = 3
+    UINT64 = 4
+    FLOAT = 5
+    DOUBLE = 6
+    VEC2F = 7
+    VEC3F = 8
+    VEC2U = 9
+    VEC3U = 10
+    MAT4 = 11
+    BYTES = 12
+
+class FieldInfo:
+    """Named member of a component at a byte offset."""
+
+    name: str
+    type: FieldType
+    offset: int
+    size: int
+
+class ComponentType:
+    """Reflection metadata of a registered component type."""
+
+    id: int
+    """Process-local ID, may differ between runs."""
+    name: str
+    hash: int
+    """Hash of the name, stable across runs and processes."""
+    fields: list[FieldInfo]
+    size: int
+    """Size of one component in bytes."""
+
+    def find_field(self, name: str) -> FieldInfo | None: ...
+
+def register_component(name: str, fields: list[tuple[str, FieldType]]) -> ComponentType:
+    """
+    Registers a plain data component defined at runtime. Fields are laid out
+    in order with natural alignment. Registering a taken name returns the
+    existing type, a type without fields is a tag.
+    """
+    ...
+
+def find_component_type(name: str) -> ComponentType | None:
+    """Looks up a registered component type, built-in ones included."""
+    ...
+
+def get_component_types() -> list[ComponentType]:
+    """Returns every registered component type."""
+    ...
+
 class Registry:
     """
     The core component container and manager for the Entity Component System
@@ -61,8 +163,17 @@ class Registry:
     data pools.
     """
 
-    def __init__(self) -> None:
-        """Initializes the ECS Registry with empty component pools."""
+    def __init__(self, storage_mode: StorageMode = StorageMode.POOLED) -> None:
+        """
+        Initializes the ECS Registry with empty component pools.
+
+        Args:
+            storage_mode: Component storage backend to use.
+        """
+        ...
+
+    def get_storage_mode(self) -> StorageMode:
+        """Returns the component storage backend of the registry."""
         ...
 
     def clear(self) -> None:
@@ -72,12 +183,34 @@ class Registry:
         """
         ...
 
+    def get_memory_stats(self) -> MemoryStats:
+        """
+        Returns bytes reserved versus used by the entity table and by the
+        storage of every component type.
+        """
+        ...
+
+    def get_interpolation_alpha(self) -> float:
+        """
+        Share of a fixed step accumulated by World but not simulated yet,
+        in [0, 1). Renderers blend PreviousTransform and Transform by it.
+        Always 1 without fixed step systems.
+        """
+        ...
+
     def spawn(self) -> EntityID:
         """
         Creates and registers a new, bare Entity, returning its unique ID.
         """
         ...
 
+    def spawn_many(self, count: int) -> list[EntityID]:
+        """
+        Creates `count` bare Entities at once, returning their IDs. Faster
+        than calling spawn() in a loop.
+        """
+        ...
+
     def is_valid(self, entity: EntityID) -> bool:
         """
         Checks if the Entity ID is currently valid (i.e., its version matches
@@ -98,6 +231,119 @@ class Registry:
         """
         ...
 
+    def despawn_many(self, entities: list[EntityID]) -> None:
+        """
+        Removes all given Entities from the scene. Invalid IDs are skipped.
+        """
+        ...
+
+    def compact(self) -> list[tuple[EntityID, EntityID]]:
+        """
+        Moves live Entities into the lowest free indices and releases the
+        storage left empty, restoring iteration speed after heavy churn.
+        Parent/child links are updated automatically.
+
+        Returns:
+            (old, new) ID pairs of every relocated Entity. IDs held on the
+            Python side must be translated through it.
+        """
+        ...
+
+    def set_parent(self, child: EntityID, parent: EntityID) -> None:
+        """
+        Attaches `child` to `parent`, so its Transform becomes relative to
+        the parent once a TransformSystem runs. Passing an invalid ID
+        detaches the child again.
+        """
+        ...
+
+    def get_parent(self, entity: EntityID) -> EntityID:
+        """Returns the parent of the Entity or an invalid ID for roots."""
+        ...
+
+    def despawn_recursive(self, entity: EntityID) -> None:
+        """Removes the Entity together with all of its descendants."""
+        ...
+
+    def assign_component(self, entity: EntityID, name: str) -> None:
+        """
+        Assigns a zero initialized component of a registered type by name.
+
+        Raises:
+            KeyError: If no component type is registered under the name.
+        """
+        ...
+
+    def get_component(self, entity: EntityID, name: str) -> bytes | None:
+        """
+        Returns a copy of the raw bytes of the component, laid out as
+        described by its ComponentType, or None if it is missing or a tag.
+
+        Raises:
+            KeyError: If the type is not registered.
+            TypeError: If the type is not trivially copyable.
+        """
+        ...
+
+    def set_component(self, entity: EntityID, name: str, data: bytes) -> None:
+        """
+        Overwrites the raw bytes of the component and flags it as changed.
+
+        Raises:
+            KeyError: If the type is not registered or the Entity lacks it.
+            TypeError: If the type is not trivially copyable.
+            ValueError: If `data` does not match the size of the component.
+        """
+        ...
+
+    def get_components(self, entities: list[EntityID], name: str) -> bytes:
+        """
+        Returns a copy of the components of every Entity packed back to back
+        in the given order, serializing a whole column in one call.
+
+        Raises:
+            KeyError: If the type is not registered or an Entity lacks it.
+            TypeError: If the type is not trivially copyable.
+        """
+        ...
+
+    def set_components(self, entities: list[EntityID], name: str, data: bytes) -> None:
+        """
+        Overwrites the components of every Entity from bytes packed as
+        returned by `get_components` and flags them as changed. Nothing is
+        written if an Entity lacks the component.
+
+        Raises:
+            KeyError: If the type is not registered or an Entity lacks it.
+            TypeError: If the type is not trivially copyable.
+            ValueError: If `data` does not hold one component per Entity.
+        """
+        ...
+
+    def has_component(self, entity: EntityID, name: str) -> bool: ...
+    def remove_component(self, entity: EntityID, name: str) -> None: ...
+    def mark_changed(self, entity: EntityID, name: str) -> None:
+        """Flags the component as changed after it was modified in place."""
+        ...
+
+    def observe(
+        self, name: str, event: ObserverEvent, callback: Callable[[list[EntityID]], None]
+    ) -> int:
+        """
+        Calls `callback` with the Entities that gained or lost the named
+        component. Events are collected and delivered in one batch per
+        frame, on World.update() or dispatch_observers().
+
+        Returns:
+            ID to pass to unobserve().
+        """
+        ...
+
+    def unobserve(self, observer_id: int) -> None: ...
+    def dispatch_observers(self) -> None:
+        """Delivers the queued component events right away."""
+        ...
+
 class System:
     """
     Base class for all logic and behavior in the ECS.
@@ -136,6 +382,82 @@ class System:
         """
         ...
 
+    def get_name(self) -> str:
+        """
+        Name of the system in profiler stats and traces, queried once when
+        the system is added to the World. Defaults to the class name.
+        """
+        ...
+
+class TimingStats:
+    """Durations of the samples a profiler track holds, in milliseconds."""
+
+    name: str
+    sample_count: int
+    last_ms: float
+    mean_ms: float
+    p50_ms: float
+    p95_ms: float
+    p99_ms: float
+    max_ms: float
+
+class Profiler:
+    """Timings of World.update() and of every System, see World.get_profiler()."""
+
+    def set_enabled(self, enabled: bool, history_size: int = 256) -> None:
+        """
+        Starts or stops recording. Only the latest `history_size` samples
+        of every track are kept, changing it drops the recorded ones.
+        """
+        ...
+
+    def is_enabled(self) -> bool: ...
+    def get_stats(self) -> list[TimingStats]:
+        """
+        Returns the stats of the whole frame first, followed by those of
+        every System in the order they were added.
+        """
+        ...
+
+    def clear(self) -> None: ...
+    def to_chrome_trace(self) -> str: ...
+    def write_chrome_trace(self, path: str) -> bool:
+        """
+        Writes the recorded samples as Chrome trace event JSON, loadable in
+        chrome://tracing and Perfetto.
+        """
+        ...
+
+class Tracer:
+    """
+    Process wide trace of the engine hot paths (mesh uploads, culling,
+    event polling, Python callbacks) as Chrome trace event JSON.
+    Not recorded by distribution builds.
+    """
+
+    @staticmethod
+    def start(path: str) -> bool:
+        """Starts writing a new trace file, returns False if it can't be opened."""
+        ...
+
+    @staticmethod
+    def stop() -> None:
+        """Flushes the pending events and completes the trace file."""
+        ...
+
+    @staticmethod
+    def flush() -> None:
+        """
+        Writes the events recorded so far. Call once per frame, events
+        beyond the per thread buffer size in between are dropped.
+        """
+        ...
+
+    @staticmethod
+    def is_enabled() -> bool: ...
+    @staticmethod
+    def get_dropped_count() -> int: ...
+
 @dataclass
 class Vec2u:
     x: int
@@ -225,14 +547,16 @@ class World(Registry):
     the execution of all registered Systems.
     """
 
-    def __init__(self) -> None:
+    def __init__(self, storage_mode: StorageMode = StorageMode.POOLED) -> None:
         """Initializes the World and the list of systems."""
-        super().__init__()
+        super().__init__(storage_mode)
         ...
 
     def update(self, dt: float = 0.016) -> None:
         """
-        Executes the on_update method for all registered systems in order.
+        Executes the on_update method for all registered systems. Built-in
+        systems that declare non-conflicting component accesses may run
+        concurrently, Python systems always run alone and in order.
 
         Args:
             dt: The time elapsed since the last frame (defaulting to ~60 FPS).
@@ -249,6 +573,35 @@ class World(Registry):
         """
         ...
 
+    def get_schedule(self) -> list[list[int]]:
+        """
+        Returns the indices of the systems run by every stage, in execution
+        order. Systems of the same stage run concurrently.
+        """
+        ...
+
+    def add_fixed_system(self, system: System) -> None:
+        """
+        Adds a System that runs with a constant dt of the fixed timestep,
+        as many times per update() as whole steps have accumulated and
+        before the Systems added by add_system().
+        """
+        ...
+
+    def get_fixed_schedule(self) -> list[list[int]]: ...
+    def set_fixed_timestep(self, step: float, max_substeps: int = 8) -> None:
+        """
+        Sets the fixed step length in seconds. Frame time beyond
+        `max_substeps` steps is dropped rather than caught up later.
+        """
+        ...
+
+    def get_fixed_timestep(self) -> float: ...
+    def get_max_substeps(self) -> int: ...
+    def get_profiler(self) -> Profiler:
+        """Returns the per System profiler, disabled by default."""
+        ...
+
     def get_transform(self, entity: EntityID) -> Transform:
         """
         Get transform component of an entity
@@ -275,6 +628,70 @@ class World(Registry):
 
     def get_rigidbody(self, entity: EntityID) -> Rigidbody: ...
 
+class WorldBatch:
+    """
+    Independent Worlds with identical Systems, stepped together across
+    all cores in one call. Meant for many small simulations such as
+    reinforcement learning rollouts.
+    """
+
+    def __init__(
+        self, world_count: int, storage_mode: StorageMode = StorageMode.POOLED
+    ) -> None: ...
+    def get_world_count(self) -> int: ...
+    def get_world(self, world_idx: int) -> World:
+        """Returns a World of the batch, to populate or reset it."""
+        ...
+
+    def add_system(self, factory: Callable[[], System]) -> None:
+        """
+        Adds a System to every World. `factory` is called once per World,
+        as Systems keep per-World state.
+        """
+        ...
+
+    def add_fixed_system(self, factory: Callable[[], System]) -> None: ...
+    def set_fixed_timestep(self, step: float, max_substeps: int = 8) -> None: ...
+    def step(self, dt: float, step_count: int = 1) -> None:
+        """
+        Updates every World `step_count` times and gathers the observations.
+        The GIL is released meanwhile, Python Systems still work but run one
+        at a time.
+        """
+        ...
+
+    def set_observation(self, fields: list[tuple[str, str]], max_entities: int) -> None:
+        """
+        Selects the (component, field) pairs step() writes as float32 for
+        the first `max_entities` Entities of every World that own all the
+        listed components. Rows of missing Entities are zeroed.
+
+        Raises:
+            KeyError: If a component or field is not registered.
+        """
+        ...
+
+    def get_observation_size(self) -> int:
+        """Floats per observed Entity, vectors count one per element."""
+        ...
+
+    def get_max_observed_entities(self) -> int: ...
+    def get_observations(self) -> memoryview:
+        """
+        Returns a read-only float32 view of shape (world_count,
+        max_entities, observation_size) over a copy of the observations
+        gathered by the last step(). The next step() does not update it,
+        call this again after every step.
+        """
+        ...
+
+    def get_observed_counts(self) -> memoryview:
+        """
+        Returns a read-only uint32 view over a copy of the number of
+        Entities observed in every World by the last step().
+        """
+        ...
+
 class GpuContext:
     """
     Class representing the gpu device.
@@ -301,6 +718,15 @@ class RenderingSystem(System):
         ...
 
     def on_destroy(self, registry: Registry) -> None: ...
+    def set_transform_caching(self, enabled: bool) -> None:
+        """
+        Reuses the world matrices of entities whose transform and mesh
+        didn't change. Only safe when every write to them marks them
+        changed, as the World accessors do. Disabled by default.
+        """
+        ...
+
+    def is_transform_caching(self) -> bool: ...
 
 class PhysicsSystem(System):
     """
@@ -316,6 +742,17 @@ class PhysicsSystem(System):
 
     def on_destroy(self, registry: Registry) -> None: ...
 
+class TransformSystem(System):
+    """
+    Resolves parent/child relationships into world space matrices used for
+    rendering. Only subtrees whose transforms changed are recomputed.
+    """
+
+    def __init__(self) -> None: ...
+    def on_update(self, registry: Registry, dt: float) -> None:
+        """Propagates changed transforms down the hierarchy."""
+        ...
+
 class KeyCode(IntEnum):
     UNKNOWN = 0
     RETURN = 13
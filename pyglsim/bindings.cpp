@@ -1,16 +1,22 @@
 #include <pybind11/native_enum.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 #include <pybind11/trampoline_self_life_support.h>
 
+#include "core/component_registry.h"
 #include "core/components.h"
 #include "core/event_system.h"
 #include "core/gpu_context.h"
+#include "core/hierarchy.h"
 #include "core/input.h"
 #include "core/log.h"
+#include "core/profiler.h"
 #include "core/registry.h"
 #include "core/system.h"
 #include "core/transform.h"
+#include "core/transform_system.h"
 #include "core/world.h"
+#include "core/world_batch.h"
 #include "glgpu/vector.h"
 #include "graphics/rendering_system.h"
 #include "graphics/window.h"
@@ -27,14 +33,28 @@ public:
 	using System::System;
 
 	void on_init(Registry& p_registry) override {
+		GL_PROFILE_SCOPE("PySystem::on_init");
 		PYBIND11_OVERRIDE(void, System, on_init, p_registry);
 	}
 	void on_update(Registry& p_registry, float p_dt) override {
+		GL_PROFILE_SCOPE("PySystem::on_update");
 		PYBIND11_OVERRIDE(void, System, on_update, p_registry, p_dt);
 	}
 	void on_destroy(Registry& p_registry) override {
+		GL_PROFILE_SCOPE("PySystem::on_destroy");
 		PYBIND11_OVERRIDE(void, System, on_destroy, p_registry);
 	}
+	std::string get_name() const override {
+		py::gil_scoped_acquire gil;
+
+		const System* self = this;
+		if (py::function override = py::get_override(self, "get_name")) {
+			return override().cast<std::string>();
+		}
+
+		// The C++ name would only ever say PySystem
+		return py::str(py::type::of(py::cast(self)).attr("__name__"));
+	}
 };
 
 // Internal Event Enum for Python mapping
@@ -63,6 +83,7 @@ void _py_subscribe_event(PyEventType p_type, py::object p_func) {
 	auto cxx_wrapper = [py_callback](const auto& event_data) {
 		py::gil_scoped_release release; // Release GIL before calling back into Python
 		if (*py_callback) {
+			GL_PROFILE_SCOPE("Python event callback");
 			py::gil_scoped_acquire acquire_again;
 			try {
 				(*py_callback)(event_data);
@@ -187,22 +208,29 @@ public:
 	const Vec3f& get_position() { return registry->get<Transform>(entity)->position; }
 	void set_position(const Vec3f& p_position) {
 		registry->get<Transform>(entity)->position = p_position;
+		registry->mark_changed<Transform>(entity);
 	}
 
 	const Vec3f& get_rotation() { return registry->get<Transform>(entity)->rotation; }
 	void set_rotation(const Vec3f& p_rotation) {
 		registry->get<Transform>(entity)->rotation = p_rotation;
+		registry->mark_changed<Transform>(entity);
 	}
 
 	const Vec3f& get_scale() { return registry->get<Transform>(entity)->scale; }
-	void set_scale(const Vec3f& p_scale) { registry->get<Transform>(entity)->scale = p_scale; }
+	void set_scale(const Vec3f& p_scale) {
+		registry->get<Transform>(entity)->scale = p_scale;
+		registry->mark_changed<Transform>(entity);
+	}
 
 	void translate(const Vec3f& p_translation) {
 		registry->get<Transform>(entity)->translate(p_translation);
+		registry->mark_changed<Transform>(entity);
 	}
 
 	void rotate(float p_angle, const Vec3f& p_axis) {
 		registry->get<Transform>(entity)->rotate(p_angle, p_axis);
+		registry->mark_changed<Transform>(entity);
 	}
 
 	Vec3f get_forward() { return registry->get<Transform>(entity)->get_forward(); }
@@ -232,6 +260,7 @@ public:
 
 	void set_primitive_type(const PrimitiveType& p_type) {
 		registry->get<MeshComponent>(entity)->type = p_type;
+		registry->mark_changed<MeshComponent>(entity);
 	}
 
 private:
@@ -347,7 +376,75 @@ static void _bind_components(py::module_& m) {
 					&PyRigidbodyProxy::set_use_gravity);
 }
 
+static void _register_builtin_components() {
+	ComponentRegistry::register_type<Transform>("Transform",
+			{ GL_FIELD(Transform, position), GL_FIELD(Transform, rotation),
+					GL_FIELD(Transform, scale) });
+	ComponentRegistry::register_type<GlobalTransform>(
+			"GlobalTransform", { GL_FIELD(GlobalTransform, matrix) });
+	ComponentRegistry::register_type<PreviousTransform>(
+			"PreviousTransform", { GL_FIELD(PreviousTransform, transform) });
+	ComponentRegistry::register_type<MeshComponent>(
+			"MeshComponent", { GL_FIELD(MeshComponent, type) });
+	ComponentRegistry::register_type<Rigidbody>("Rigidbody",
+			{ GL_FIELD(Rigidbody, mass), GL_FIELD(Rigidbody, velocity),
+					GL_FIELD(Rigidbody, force_acc), GL_FIELD(Rigidbody, linear_damping),
+					GL_FIELD(Rigidbody, is_static), GL_FIELD(Rigidbody, use_gravity) });
+}
+
+static const ComponentType& _get_component_type(const std::string& name) {
+	const ComponentType* type = ComponentRegistry::find(name);
+	if (!type) {
+		throw py::key_error("Component type '" + name + "' is not registered");
+	}
+	return *type;
+}
+
+// Raw bytes of types owning memory (vectors, shared pointers) would expose
+// or overwrite their pointers, only trivially copyable ones are accessible
+static const ComponentType& _get_plain_component_type(const std::string& name) {
+	const ComponentType& type = _get_component_type(name);
+	if (type.info.destroy || type.info.move || type.info.copy) {
+		throw py::type_error("Component '" + name + "' is not trivially copyable");
+	}
+	return type;
+}
+
+/**
+ * Read-only copy of a buffer handed to Python through the buffer protocol,
+ * the memoryviews created from it keep it alive
+ */
+struct PyBufferCopy {
+	std::vector<uint8_t> data;
+	std::string format;
+	py::ssize_t itemsize = 0;
+	std::vector<py::ssize_t> shape;
+
+	template <typename T>
+	static py::memoryview view(std::span<const T> values, std::vector<py::ssize_t> shape) {
+		PyBufferCopy copy;
+		copy.data.resize(values.size_bytes());
+		std::memcpy(copy.data.data(), values.data(), values.size_bytes());
+		copy.format = py::format_descriptor<T>::format();
+		copy.itemsize = sizeof(T);
+		copy.shape = std::move(shape);
+		return py::memoryview(py::cast(std::move(copy)));
+	}
+};
+
 static void _bind_ecs(py::module_& m) {
+	py::class_<PyBufferCopy>(m, "_BufferCopy", py::buffer_protocol())
+			.def_buffer([](PyBufferCopy& self) {
+				std::vector<py::ssize_t> strides(self.shape.size());
+				py::ssize_t stride = self.itemsize;
+				for (size_t i = self.shape.size(); i-- > 0;) {
+					strides[i] = stride;
+					stride *= self.shape[i];
+				}
+				return py::buffer_info(self.data.data(), self.itemsize, self.format,
+						self.shape.size(), self.shape, strides, true);
+			});
+
 	py::class_<Entity>(m, "Entity")
 			.def(py::init<>())
 			.def("__int__", [](const Entity& e) { return (uint64_t)e; })
@@ -355,23 +452,304 @@ static void _bind_ecs(py::module_& m) {
 			.def_static("get_index", &get_entity_index)
 			.def_static("get_version", &get_entity_version);
 
+	py::native_enum<StorageMode>(m, "StorageMode", "enum.Enum")
+			.value("POOLED", StorageMode::POOLED)
+			.value("ARCHETYPE", StorageMode::ARCHETYPE)
+			.export_values()
+			.finalize();
+
+	py::native_enum<ObserverEvent>(m, "ObserverEvent", "enum.Enum")
+			.value("ADDED", ObserverEvent::ADDED)
+			.value("REMOVED", ObserverEvent::REMOVED)
+			.finalize();
+
+	py::class_<ComponentMemoryStats>(m, "ComponentMemoryStats")
+			.def_readonly("component_id", &ComponentMemoryStats::component_id)
+			.def_readonly("component_size", &ComponentMemoryStats::component_size)
+			.def_readonly("count", &ComponentMemoryStats::count)
+			.def_readonly("bytes_reserved", &ComponentMemoryStats::bytes_reserved)
+			.def_readonly("bytes_used", &ComponentMemoryStats::bytes_used)
+			.def_readonly("dense_pages", &ComponentMemoryStats::dense_pages)
+			.def_readonly("sparse_pages", &ComponentMemoryStats::sparse_pages)
+			.def_readonly("shared_pages", &ComponentMemoryStats::shared_pages)
+			.def_property_readonly("fragmentation", &ComponentMemoryStats::get_fragmentation);
+
+	py::class_<MemoryStats>(m, "MemoryStats")
+			.def_readonly("components", &MemoryStats::components)
+			.def_readonly("entity_count", &MemoryStats::entity_count)
+			.def_readonly("entity_capacity", &MemoryStats::entity_capacity)
+			.def_readonly("free_list_length", &MemoryStats::free_list_length)
+			.def_readonly("entity_bytes_reserved", &MemoryStats::entity_bytes_reserved)
+			.def_readonly("entity_bytes_used", &MemoryStats::entity_bytes_used)
+			.def_readonly("archetype_count", &MemoryStats::archetype_count)
+			.def_property_readonly("bytes_reserved", &MemoryStats::get_bytes_reserved)
+			.def_property_readonly("bytes_used", &MemoryStats::get_bytes_used)
+			.def_property_readonly("fragmentation", &MemoryStats::get_fragmentation);
+
+	py::native_enum<FieldType>(m, "FieldType", "enum.Enum")
+			.value("BOOL", FieldType::BOOL)
+			.value("INT32", FieldType::INT32)
+			.value("UINT32", FieldType::UINT32)
+			.value("INT64", FieldType::INT64)
+			.value("UINT64", FieldType::UINT64)
+			.value("FLOAT", FieldType::FLOAT)
+			.value("DOUBLE", FieldType::DOUBLE)
+			.value("VEC2F", FieldType::VEC2F)
+			.value("VEC3F", FieldType::VEC3F)
+			.value("VEC2U", FieldType::VEC2U)
+			.value("VEC3U", FieldType::VEC3U)
+			.value("MAT4", FieldType::MAT4)
+			.value("BYTES", FieldType::BYTES)
+			.finalize();
+
+	py::class_<FieldInfo>(m, "FieldInfo")
+			.def_readonly("name", &FieldInfo::name)
+			.def_readonly("type", &FieldInfo::type)
+			.def_readonly("offset", &FieldInfo::offset)
+			.def_readonly("size", &FieldInfo::size);
+
+	py::class_<ComponentType>(m, "ComponentType")
+			.def_readonly("id", &ComponentType::id)
+			.def_readonly("name", &ComponentType::name)
+			.def_readonly("hash", &ComponentType::hash)
+			.def_readonly("fields", &ComponentType::fields)
+			.def_property_readonly(
+					"size", [](const ComponentType& self) { return self.info.size; })
+			.def("find_field", &ComponentType::find_field,
+					py::return_value_policy::reference_internal);
+
+	m.def(
+			"register_component",
+			[](const std::string& name,
+					const std::vector<std::pair<std::string, FieldType>>& fields)
+					-> const ComponentType& {
+				std::vector<FieldInfo> infos;
+				infos.reserve(fields.size());
+				for (const auto& [field_name, type] : fields) {
+					infos.push_back(FieldInfo{ field_name, type });
+				}
+				return ComponentRegistry::register_type(name, std::move(infos));
+			},
+			py::arg("p_name"), py::arg("p_fields"), py::return_value_policy::reference);
+	m.def(
+			"find_component_type",
+			[](const std::string& name) { return ComponentRegistry::find(name); },
+			py::arg("p_name"), py::return_value_policy::reference);
+	m.def("get_component_types", &ComponentRegistry::get_types,
+			py::return_value_policy::reference);
+
 	py::class_<Registry>(m, "Registry")
-			.def(py::init<>())
+			.def(py::init<StorageMode>(), py::arg("p_storage_mode") = StorageMode::POOLED)
+			.def("get_storage_mode", &Registry::get_storage_mode)
 			.def("clear", &Registry::clear)
+			.def("get_memory_stats", &Registry::get_memory_stats)
+			.def("get_interpolation_alpha", &Registry::get_interpolation_alpha)
 			.def("spawn", &Registry::spawn)
+			.def(
+					"spawn_many",
+					[](Registry& self, uint32_t count) {
+						std::vector<Entity> entities(count);
+						self.spawn_many(entities);
+						return entities;
+					},
+					py::arg("p_count"))
 			.def("is_valid", &Registry::is_valid)
-			.def("despawn", &Registry::despawn);
+			.def("despawn", &Registry::despawn)
+			.def(
+					"despawn_many",
+					[](Registry& self, const std::vector<Entity>& entities) {
+						self.despawn_many(entities);
+					},
+					py::arg("p_entities"))
+			.def("compact",
+					[](Registry& self) {
+						const std::vector<EntityRemap> remap = self.compact();
+
+						std::vector<std::pair<Entity, Entity>> result;
+						result.reserve(remap.size());
+						for (const EntityRemap& entry : remap) {
+							result.emplace_back(entry.from, entry.to);
+						}
+						return result;
+					})
+			.def("set_parent", &set_parent, py::arg("p_child"), py::arg("p_parent"))
+			.def("get_parent", &get_parent, py::arg("p_entity"))
+			.def("despawn_recursive", &despawn_recursive, py::arg("p_entity"))
+			.def(
+					"assign_component",
+					[](Registry& self, Entity entity, const std::string& name) {
+						self.assign(entity, _get_component_type(name).id);
+					},
+					py::arg("p_entity"), py::arg("p_name"))
+			.def(
+					"get_component",
+					[](const Registry& self, Entity entity, const std::string& name) -> py::object {
+						const ComponentType& type = _get_plain_component_type(name);
+						// Copied, a view would dangle once the storage moves
+						const void* component = self.get(entity, type.id);
+						if (!component) {
+							return py::none();
+						}
+						return py::bytes(static_cast<const char*>(component), type.info.size);
+					},
+					py::arg("p_entity"), py::arg("p_name"))
+			.def(
+					"set_component",
+					[](Registry& self, Entity entity, const std::string& name,
+							const py::bytes& data) {
+						const ComponentType& type = _get_plain_component_type(name);
+						const std::string_view bytes = data;
+						if (bytes.size() != type.info.size) {
+							throw py::value_error("Component '" + name + "' is " +
+									std::to_string(type.info.size) + " bytes, got " +
+									std::to_string(bytes.size()));
+						}
+
+						void* component = self.get(entity, type.id);
+						if (!component) {
+							throw py::key_error("Entity has no component '" + name + "'");
+						}
+
+						std::memcpy(component, bytes.data(), bytes.size());
+						self.mark_changed(entity, type.id);
+					},
+					py::arg("p_entity"), py::arg("p_name"), py::arg("p_data"))
+			.def(
+					"get_components",
+					[](const Registry& self, const std::vector<Entity>& entities,
+							const std::string& name) {
+						const ComponentType& type = _get_plain_component_type(name);
+						const size_t size = type.info.size;
+
+						// Written in place, the column is copied once
+						py::bytes result = py::reinterpret_steal<py::bytes>(
+								PyBytes_FromStringAndSize(nullptr, entities.size() * size));
+						char* dst = PyBytes_AS_STRING(result.ptr());
+						for (const Entity entity : entities) {
+							const void* component = self.get(entity, type.id);
+							if (!component) {
+								throw py::key_error("Entity has no component '" + name + "'");
+							}
+							std::memcpy(dst, component, size);
+							dst += size;
+						}
+						return result;
+					},
+					py::arg("p_entities"), py::arg("p_name"))
+			.def(
+					"set_components",
+					[](Registry& self, const std::vector<Entity>& entities, const std::string& name,
+							const py::bytes& data) {
+						const ComponentType& type = _get_plain_component_type(name);
+						const size_t size = type.info.size;
+						const std::string_view bytes = data;
+						if (bytes.size() != entities.size() * size) {
+							throw py::value_error("Expected " +
+									std::to_string(entities.size() * size) + " bytes for " +
+									std::to_string(entities.size()) + " '" + name +
+									"' components, got " + std::to_string(bytes.size()));
+						}
+
+						for (const Entity entity : entities) {
+							if (!self.has(entity, type.id)) {
+								throw py::key_error("Entity has no component '" + name + "'");
+							}
+						}
+
+						const char* src = bytes.data();
+						for (const Entity entity : entities) {
+							std::memcpy(self.get(entity, type.id), src, size);
+							self.mark_changed(entity, type.id);
+							src += size;
+						}
+					},
+					py::arg("p_entities"), py::arg("p_name"), py::arg("p_data"))
+			.def(
+					"has_component",
+					[](Registry& self, Entity entity, const std::string& name) {
+						return self.has(entity, _get_component_type(name).id);
+					},
+					py::arg("p_entity"), py::arg("p_name"))
+			.def(
+					"remove_component",
+					[](Registry& self, Entity entity, const std::string& name) {
+						self.remove(entity, _get_component_type(name).id);
+					},
+					py::arg("p_entity"), py::arg("p_name"))
+			.def(
+					"mark_changed",
+					[](Registry& self, Entity entity, const std::string& name) {
+						self.mark_changed(entity, _get_component_type(name).id);
+					},
+					py::arg("p_entity"), py::arg("p_name"))
+			.def(
+					"observe",
+					[](Registry& self, const std::string& name, ObserverEvent event,
+							py::function callback) {
+						// Shared so that copies of the observer never touch the reference
+						// count of the function without holding the GIL
+						auto fn = std::shared_ptr<py::function>(
+								new py::function(std::move(callback)), [](py::function* fn) {
+									py::gil_scoped_acquire gil;
+									delete fn;
+								});
+
+						return self.observe(_get_component_type(name).id, event,
+								[fn](Registry&, std::span<const Entity> entities) {
+									GL_PROFILE_SCOPE("Python observer");
+									py::gil_scoped_acquire gil;
+									(*fn)(std::vector<Entity>(entities.begin(), entities.end()));
+								});
+					},
+					py::arg("p_name"), py::arg("p_event"), py::arg("p_callback"))
+			.def("unobserve", &Registry::unobserve, py::arg("p_observer_id"))
+			.def("dispatch_observers", &Registry::dispatch_observers);
 
 	py::class_<System, PySystem, py::smart_holder>(m, "System")
 			.def(py::init<>())
 			.def("on_init", &System::on_init)
 			.def("on_update", &System::on_update)
-			.def("on_destroy", &System::on_destroy);
+			.def("on_destroy", &System::on_destroy)
+			.def("get_name", &System::get_name);
+
+	py::class_<TimingStats>(m, "TimingStats")
+			.def_readonly("name", &TimingStats::name)
+			.def_readonly("sample_count", &TimingStats::sample_count)
+			.def_readonly("last_ms", &TimingStats::last_ms)
+			.def_readonly("mean_ms", &TimingStats::mean_ms)
+			.def_readonly("p50_ms", &TimingStats::p50_ms)
+			.def_readonly("p95_ms", &TimingStats::p95_ms)
+			.def_readonly("p99_ms", &TimingStats::p99_ms)
+			.def_readonly("max_ms", &TimingStats::max_ms);
+
+	py::class_<Profiler>(m, "Profiler")
+			.def("set_enabled", &Profiler::set_enabled, py::arg("p_enabled"),
+					py::arg("p_history_size") = Profiler::DEFAULT_HISTORY_SIZE)
+			.def("is_enabled", &Profiler::is_enabled)
+			.def("get_stats", &Profiler::get_all_stats)
+			.def("clear", &Profiler::clear)
+			.def("to_chrome_trace", &Profiler::to_chrome_trace)
+			.def("write_chrome_trace", &Profiler::write_chrome_trace, py::arg("p_path"));
+
+	py::class_<Tracer>(m, "Tracer")
+			.def_static("start", &Tracer::start, py::arg("p_path"))
+			.def_static("stop", &Tracer::stop)
+			.def_static("flush", &Tracer::flush)
+			.def_static("is_enabled", &Tracer::is_enabled)
+			.def_static("get_dropped_count", &Tracer::get_dropped_count);
 
 	py::class_<World, Registry>(m, "World")
-			.def(py::init<>())
+			.def(py::init<StorageMode>(), py::arg("p_storage_mode") = StorageMode::POOLED)
 			.def("update", &World::update, py::arg("p_dt") = 0.016f)
 			.def("add_system", &World::add_system)
+			.def("get_schedule", &World::get_schedule)
+			.def("add_fixed_system", &World::add_fixed_system)
+			.def("get_fixed_schedule", &World::get_fixed_schedule)
+			.def("set_fixed_timestep", &World::set_fixed_timestep, py::arg("p_step"),
+					py::arg("p_max_substeps") = World::DEFAULT_MAX_SUBSTEPS)
+			.def("get_fixed_timestep", &World::get_fixed_timestep)
+			.def("get_max_substeps", &World::get_max_substeps)
+			.def("get_profiler", &World::get_profiler, py::return_value_policy::reference_internal)
 			.def("get_transform",
 					[](World& self, Entity entity) { return PyTransformProxy(self, entity, true); })
 			.def("get_camera",
@@ -398,6 +776,71 @@ static void _bind_ecs(py::module_& m) {
 
 				return PyRigidbodyProxy(self, entity, true);
 			});
+
+	py::class_<WorldBatch>(m, "WorldBatch")
+			.def(py::init<uint32_t, StorageMode>(), py::arg("p_world_count"),
+					py::arg("p_storage_mode") = StorageMode::POOLED)
+			.def("get_world_count", &WorldBatch::get_world_count)
+			.def("get_world", &WorldBatch::get_world, py::arg("p_world_idx"),
+					py::return_value_policy::reference_internal)
+			.def(
+					"add_system",
+					[](WorldBatch& self, const py::function& factory) {
+						self.add_system(
+								[&]() { return factory().cast<std::shared_ptr<System>>(); });
+					},
+					py::arg("p_factory"))
+			.def(
+					"add_fixed_system",
+					[](WorldBatch& self, const py::function& factory) {
+						self.add_fixed_system(
+								[&]() { return factory().cast<std::shared_ptr<System>>(); });
+					},
+					py::arg("p_factory"))
+			.def("set_fixed_timestep", &WorldBatch::set_fixed_timestep, py::arg("p_step"),
+					py::arg("p_max_substeps") = World::DEFAULT_MAX_SUBSTEPS)
+			// Python systems reacquire the GIL themselves
+			.def("step", &WorldBatch::step, py::arg("p_dt"), py::arg("p_step_count") = 1,
+					py::call_guard<py::gil_scoped_release>())
+			.def(
+					"set_observation",
+					[](WorldBatch& self,
+							const std::vector<std::pair<std::string, std::string>>& fields,
+							uint32_t max_entities) {
+						std::vector<ObservationField> observation;
+						for (const auto& [component_name, field_name] : fields) {
+							const ComponentType& type = _get_component_type(component_name);
+
+							const FieldInfo* field = type.find_field(field_name);
+							if (!field) {
+								throw py::key_error("Component '" + component_name +
+										"' has no field '" + field_name + "'");
+							}
+							if (field->type == FieldType::BYTES) {
+								throw py::type_error("Field '" + field_name +
+										"' can not be converted to floats");
+							}
+
+							observation.push_back({ type.id, *field });
+						}
+						self.set_observation(std::move(observation), max_entities);
+					},
+					py::arg("p_fields"), py::arg("p_max_entities"))
+			.def("get_observation_size", &WorldBatch::get_observation_size)
+			.def("get_max_observed_entities", &WorldBatch::get_max_observed_entities)
+			// Copied, views of the batch buffers would dangle once the batch is
+			// dropped or set_observation reallocates them
+			.def("get_observations",
+					[](const WorldBatch& self) {
+						return PyBufferCopy::view(self.get_observations(),
+								{ (py::ssize_t)self.get_world_count(),
+										(py::ssize_t)self.get_max_observed_entities(),
+										(py::ssize_t)self.get_observation_size() });
+					})
+			.def("get_observed_counts", [](const WorldBatch& self) {
+				const std::span<const uint32_t> counts = self.get_observed_counts();
+				return PyBufferCopy::view(counts, { (py::ssize_t)counts.size() });
+			});
 }
 
 static void _bind_systems(py::module_& m) {
@@ -410,10 +853,16 @@ static void _bind_systems(py::module_& m) {
 			.def("poll_events", &Window::poll_events);
 
 	py::class_<RenderingSystem, System, py::smart_holder>(m, "RenderingSystem")
-			.def(py::init<GpuContext&, std::shared_ptr<Window>>());
+			.def(py::init<GpuContext&, std::shared_ptr<Window>>())
+			.def("set_transform_caching", &RenderingSystem::set_transform_caching,
+					py::arg("p_enabled"))
+			.def("is_transform_caching", &RenderingSystem::is_transform_caching);
 
 	py::class_<PhysicsSystem, System, py::smart_holder>(m, "PhysicsSystem")
 			.def(py::init<GpuContext&>());
+
+	py::class_<TransformSystem, System, py::smart_holder>(m, "TransformSystem")
+			.def(py::init<>());
 }
 
 static void _bind_input(py::module_& m) {
@@ -726,6 +1175,8 @@ static void _bind_input(py::module_& m) {
 }
 
 PYBIND11_MODULE(_pyglsim, m, py::mod_gil_not_used()) {
+	_register_builtin_components();
+
 	_bind_math(m);
 	_bind_components(m);
 	_bind_ecs(m);
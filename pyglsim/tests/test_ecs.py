@@ -27,6 +27,42 @@ class TestECS(unittest.TestCase):
         # if we not delete the world MySystem::on_destroy would not get called
         del world
 
+    def test_component_bytes(self):
+        world = World()
+        entity = world.spawn()
+        world.assign_component(entity, "Transform")
+
+        data = bytearray(world.get_component(entity, "Transform"))
+        data[0:4] = b"\x00\x00\x80\x3f"
+        world.set_component(entity, "Transform", bytes(data))
+
+        self.assertEqual(world.get_component(entity, "Transform"), bytes(data))
+        self.assertIsNone(world.get_component(entity, "Rigidbody"))
+        with self.assertRaises(ValueError):
+            world.set_component(entity, "Transform", b"\x00")
+
+    def test_component_columns(self):
+        world = World()
+        entities = world.spawn_many(3)
+        for entity in entities:
+            world.assign_component(entity, "Transform")
+
+        size = len(world.get_component(entities[0], "Transform"))
+        data = bytearray(world.get_components(entities, "Transform"))
+        self.assertEqual(len(data), 3 * size)
+
+        data[size : size + 4] = b"\x00\x00\x80\x3f"
+        world.set_components(entities, "Transform", bytes(data))
+
+        self.assertEqual(world.get_components(entities, "Transform"), bytes(data))
+        self.assertEqual(
+            world.get_component(entities[1], "Transform"), bytes(data[size : 2 * size])
+        )
+        with self.assertRaises(ValueError):
+            world.set_components(entities, "Transform", bytes(data[:size]))
+        with self.assertRaises(KeyError):
+            world.get_components(entities, "Rigidbody")
+
 
 if __name__ == "__main__":
     if "-d" in sys.argv or "--debug" in sys.argv:
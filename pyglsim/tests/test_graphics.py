@@ -52,7 +52,8 @@ def main() -> None:
     rb = world.get_rigidbody(e)
     rb.use_gravity = False
 
-    world.add_system(PhysicsSystem(gpu))
+    world.add_fixed_system(PhysicsSystem(gpu))
+    world.set_fixed_timestep(1 / 240)
 
     last = time.time()
     while True:
@@ -19,7 +19,8 @@ int main(int argc, char* argv[]) {
 	auto window = std::make_shared<Window>(gpu, Vec2u{ 800, 600 }, "Glsim Sandbox");
 
 	world.add_system(std::make_shared<RenderingSystem>(gpu, window));
-	world.add_system(std::make_shared<PhysicsSystem>(gpu));
+	world.add_fixed_system(std::make_shared<PhysicsSystem>(gpu));
+	world.set_fixed_timestep(1.0f / 240.0f);
 
 	Entity camera = world.spawn();
 	{
@@ -37,6 +38,8 @@ int main(int argc, char* argv[]) {
 	auto transform = world.assign<Transform>(entity);
 	transform->scale = Vec3f(0.25f);
 
+	world.assign<PreviousTransform>(entity)->transform = *transform;
+
 	auto rb = world.assign<Rigidbody>(entity);
 	rb->use_gravity = false;
 
@@ -0,0 +1,217 @@
+#pragma once
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace gl {
+
+inline constexpr uint32_t MAX_COMPONENTS = 256;
+
+/**
+ * Fixed-width set of component ids, laid out as 64-bit words aligned to a
+ * 256-bit boundary so that mask tests compile down to a few SIMD ops.
+ */
+struct alignas(32) ComponentMask {
+	static constexpr uint32_t WORD_COUNT = MAX_COMPONENTS / 64;
+
+	uint64_t words[WORD_COUNT] = {};
+
+	void set(uint32_t component_id) { words[component_id / 64] |= 1ull << (component_id % 64); }
+
+	void reset(uint32_t component_id) {
+		words[component_id / 64] &= ~(1ull << (component_id % 64));
+	}
+
+	void reset() { *this = {}; }
+
+	bool test(uint32_t component_id) const {
+		return (words[component_id / 64] >> (component_id % 64)) & 1;
+	}
+
+	bool any() const;
+
+	bool none() const { return !any(); }
+
+	/**
+	 * Whether every bit set in other is also set in this mask
+	 */
+	bool contains(const ComponentMask& other) const;
+
+	/**
+	 * Invokes fn(component_id) for every set bit in ascending order
+	 */
+	template <typename Func> void for_each(Func&& fn) const {
+		for (uint32_t word_idx = 0; word_idx < WORD_COUNT; word_idx++) {
+			uint64_t word = words[word_idx];
+			while (word) {
+				fn(word_idx * 64 + std::countr_zero(word));
+				word &= word - 1;
+			}
+		}
+	}
+
+	ComponentMask operator&(const ComponentMask& other) const;
+
+	ComponentMask operator|(const ComponentMask& other) const;
+
+	ComponentMask operator~() const;
+
+	bool operator==(const ComponentMask& other) const;
+
+	bool operator!=(const ComponentMask& other) const { return !(*this == other); }
+};
+
+inline bool ComponentMask::any() const {
+#if defined(__AVX2__)
+	const __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(words));
+	return !_mm256_testz_si256(v, v);
+#else
+	uint64_t acc = 0;
+	for (uint32_t i = 0; i < WORD_COUNT; i++) {
+		acc |= words[i];
+	}
+	return acc != 0;
+#endif
+}
+
+inline bool ComponentMask::contains(const ComponentMask& other) const {
+#if defined(__AVX2__)
+	const __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(words));
+	const __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(other.words));
+	// (~a & b) == 0
+	return _mm256_testc_si256(a, b);
+#else
+	uint64_t missing = 0;
+	for (uint32_t i = 0; i < WORD_COUNT; i++) {
+		missing |= other.words[i] & ~words[i];
+	}
+	return missing == 0;
+#endif
+}
+
+inline ComponentMask ComponentMask::operator&(const ComponentMask& other) const {
+	ComponentMask result;
+	for (uint32_t i = 0; i < WORD_COUNT; i++) {
+		result.words[i] = words[i] & other.words[i];
+	}
+	return result;
+}
+
+inline ComponentMask ComponentMask::operator|(const ComponentMask& other) const {
+	ComponentMask result;
+	for (uint32_t i = 0; i < WORD_COUNT; i++) {
+		result.words[i] = words[i] | other.words[i];
+	}
+	return result;
+}
+
+inline ComponentMask ComponentMask::operator~() const {
+	ComponentMask result;
+	for (uint32_t i = 0; i < WORD_COUNT; i++) {
+		result.words[i] = ~words[i];
+	}
+	return result;
+}
+
+inline bool ComponentMask::operator==(const ComponentMask& other) const {
+	uint64_t diff = 0;
+	for (uint32_t i = 0; i < WORD_COUNT; i++) {
+		diff |= words[i] ^ other.words[i];
+	}
+	return diff == 0;
+}
+
+/**
+ * Walks the indices of the masks containing a given mask. Masks are tested
+ * in batches into a match bitmap so that long scans are bound by memory
+ * bandwidth rather than branches, the matches of a batch are then handed
+ * out from the bitmap without being tested again.
+ */
+class MaskScan {
+public:
+	explicit MaskScan(size_t start = 0) : _next(start) {}
+
+	/**
+	 * Next index of masks[0, count) containing mask, or count once none is
+	 * left. The array may move between calls as long as it is not shrunk.
+	 *
+	 * @param masks pointer or array whose elements are contiguous within
+	 * every BATCH_SIZE aligned batch, such as a PagedArray
+	 */
+	template <typename TMasks>
+	size_t next(const TMasks& masks, size_t count, const ComponentMask& mask);
+
+	static constexpr size_t BATCH_SIZE = 8;
+
+private:
+	// First index not tested yet
+	size_t _next;
+	// Untaken matches of the batch ending at _next
+	uint32_t _bitmap = 0;
+};
+
+template <typename TMasks>
+inline size_t MaskScan::next(const TMasks& masks, size_t count, const ComponentMask& mask) {
+	if (_bitmap) {
+		const size_t idx = _next - BATCH_SIZE + std::countr_zero(_bitmap);
+		_bitmap &= _bitmap - 1;
+		return idx;
+	}
+
+#if defined(__AVX2__)
+	const __m256i query = _mm256_load_si256(reinterpret_cast<const __m256i*>(mask.words));
+#endif
+
+	// Unaligned starts are tested one by one up to the first batch
+	while (_next % BATCH_SIZE != 0 && _next < count) {
+		const size_t idx = _next++;
+		if (masks[idx].contains(mask)) {
+			return idx;
+		}
+	}
+
+	while (_next + BATCH_SIZE <= count) {
+		const ComponentMask* batch = &masks[_next];
+
+		uint32_t bitmap = 0;
+		for (size_t i = 0; i < BATCH_SIZE; i++) {
+#if defined(__AVX2__)
+			const __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(batch[i].words));
+			bitmap |= static_cast<uint32_t>(_mm256_testc_si256(v, query)) << i;
+#else
+			bitmap |= static_cast<uint32_t>(batch[i].contains(mask)) << i;
+#endif
+		}
+
+		_next += BATCH_SIZE;
+
+		if (bitmap) {
+			_bitmap = bitmap & (bitmap - 1);
+			return _next - BATCH_SIZE + std::countr_zero(bitmap);
+		}
+	}
+
+	while (_next < count) {
+		const size_t idx = _next++;
+		if (masks[idx].contains(mask)) {
+			return idx;
+		}
+	}
+
+	return count;
+}
+
+} //namespace gl
+
+namespace std {
+template <> struct hash<gl::ComponentMask> {
+	size_t operator()(const gl::ComponentMask& mask) const {
+		size_t seed = 0;
+		for (uint64_t word : mask.words) {
+			seed ^= std::hash<uint64_t>{}(word) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+		}
+		return seed;
+	}
+};
+} //namespace std
@@ -0,0 +1,190 @@
+#include "core/component_registry.h"
+
+namespace gl {
+
+static std::mutex s_types_mutex;
+static std::vector<std::unique_ptr<ComponentType>> s_types_by_id;
+static std::unordered_map<uint64_t, ComponentType*> s_types_by_hash;
+
+size_t get_field_type_size(FieldType type) {
+	switch (type) {
+		case FieldType::BOOL:
+			return sizeof(bool);
+		case FieldType::INT32:
+		case FieldType::UINT32:
+		case FieldType::FLOAT:
+			return 4;
+		case FieldType::INT64:
+		case FieldType::UINT64:
+		case FieldType::DOUBLE:
+			return 8;
+		case FieldType::VEC2F:
+			return sizeof(Vec2f);
+		case FieldType::VEC3F:
+			return sizeof(Vec3f);
+		case FieldType::VEC2U:
+			return sizeof(Vec2u);
+		case FieldType::VEC3U:
+			return sizeof(Vec3u);
+		case FieldType::MAT4:
+			return sizeof(Mat4);
+		default:
+			return 0;
+	}
+}
+
+size_t get_field_type_alignment(FieldType type) {
+	switch (type) {
+		case FieldType::VEC2F:
+			return alignof(Vec2f);
+		case FieldType::VEC3F:
+			return alignof(Vec3f);
+		case FieldType::VEC2U:
+			return alignof(Vec2u);
+		case FieldType::VEC3U:
+			return alignof(Vec3u);
+		case FieldType::MAT4:
+			return alignof(Mat4);
+		case FieldType::BYTES:
+			return 1;
+		default:
+			return get_field_type_size(type);
+	}
+}
+
+const FieldInfo* ComponentType::find_field(std::string_view field_name) const {
+	for (const FieldInfo& field : fields) {
+		if (field.name == field_name) {
+			return &field;
+		}
+	}
+
+	return nullptr;
+}
+
+uint64_t hash_component_name(std::string_view name) {
+	uint64_t hash = 14695981039346656037ull;
+	for (const char c : name) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+const ComponentType& ComponentRegistry::register_type(
+		std::string_view name, size_t size, size_t alignment, std::vector<FieldInfo> fields) {
+	if (const ComponentType* type = find(name)) {
+		GL_ASSERT(type->info.size == size, "Component type registered again with another size");
+		return *type;
+	}
+
+	for (const FieldInfo& field : fields) {
+		GL_ASSERT(field.offset + field.size <= size, "Field is out of the component bounds");
+	}
+
+	ComponentType type;
+	type.id = INVALID_COMPONENT_ID;
+	type.name = name;
+	type.hash = hash_component_name(name);
+	type.fields = std::move(fields);
+
+	// Plain data, constructed by zeroing and relocated with memcpy
+	type.info.size = size;
+	type.info.alignment = alignment;
+
+	return _register(std::move(type));
+}
+
+const ComponentType& ComponentRegistry::register_type(
+		std::string_view name, std::vector<FieldInfo> fields) {
+	if (const ComponentType* type = find(name)) {
+		return *type;
+	}
+
+	size_t size = 0;
+	size_t alignment = 1;
+
+	for (FieldInfo& field : fields) {
+		if (field.type != FieldType::BYTES) {
+			field.size = get_field_type_size(field.type);
+		}
+
+		const size_t field_alignment = get_field_type_alignment(field.type);
+		field.offset = (size + field_alignment - 1) / field_alignment * field_alignment;
+
+		size = field.offset + field.size;
+		alignment = std::max(alignment, field_alignment);
+	}
+
+	// Pad to a multiple of the alignment so that components stay aligned
+	// when packed in arrays
+	size = (size + alignment - 1) / alignment * alignment;
+
+	return register_type(name, size, alignment, std::move(fields));
+}
+
+const ComponentType* ComponentRegistry::find(std::string_view name) {
+	return find(hash_component_name(name));
+}
+
+const ComponentType* ComponentRegistry::find(uint64_t hash) {
+	std::lock_guard<std::mutex> lock(s_types_mutex);
+
+	const auto it = s_types_by_hash.find(hash);
+	return it != s_types_by_hash.end() ? it->second : nullptr;
+}
+
+const ComponentType* ComponentRegistry::get(uint32_t component_id) {
+	std::lock_guard<std::mutex> lock(s_types_mutex);
+
+	if (component_id >= s_types_by_id.size()) {
+		return nullptr;
+	}
+
+	return s_types_by_id[component_id].get();
+}
+
+std::vector<const ComponentType*> ComponentRegistry::get_types() {
+	std::lock_guard<std::mutex> lock(s_types_mutex);
+
+	std::vector<const ComponentType*> types;
+	for (const auto& type : s_types_by_id) {
+		if (type) {
+			types.push_back(type.get());
+		}
+	}
+
+	return types;
+}
+
+const ComponentType& ComponentRegistry::_register(ComponentType type) {
+	std::lock_guard<std::mutex> lock(s_types_mutex);
+
+	if (const auto it = s_types_by_hash.find(type.hash); it != s_types_by_hash.end()) {
+		GL_ASSERT(type.id == INVALID_COMPONENT_ID || it->second->id == type.id,
+				"Component name is already taken by another type");
+		return *it->second;
+	}
+
+	// Runtime types only take an id once the name is known to be free
+	if (type.id == INVALID_COMPONENT_ID) {
+		type.id = allocate_component_id();
+	}
+
+	const uint32_t component_id = type.id;
+	if (s_types_by_id.size() <= component_id) {
+		s_types_by_id.resize(component_id + 1);
+	}
+
+	GL_ASSERT(!s_types_by_id[component_id], "Component type is already registered by another name");
+
+	s_types_by_id[component_id] = std::make_unique<ComponentType>(std::move(type));
+
+	ComponentType* registered = s_types_by_id[component_id].get();
+	s_types_by_hash[registered->hash] = registered;
+
+	return *registered;
+}
+
+} //namespace gl
@@ -0,0 +1,163 @@
+/**
+ * @file component_registry.h
+ */
+
+#pragma once
+
+#include "core/registry.h"
+#include "glgpu/matrix.h"
+#include "glgpu/vector.h"
+
+namespace gl {
+
+enum class FieldType : uint8_t {
+	BOOL,
+	INT32,
+	UINT32,
+	INT64,
+	UINT64,
+	FLOAT,
+	DOUBLE,
+	VEC2F,
+	VEC3F,
+	VEC2U,
+	VEC3U,
+	MAT4,
+	// Anything else, only its size is known
+	BYTES,
+};
+
+size_t get_field_type_size(FieldType type);
+
+size_t get_field_type_alignment(FieldType type);
+
+template <typename T> constexpr FieldType get_field_type() {
+	if constexpr (std::is_enum_v<T>) {
+		return get_field_type<std::underlying_type_t<T>>();
+	} else if constexpr (std::is_same_v<T, bool>) {
+		return FieldType::BOOL;
+	} else if constexpr (std::is_same_v<T, int32_t>) {
+		return FieldType::INT32;
+	} else if constexpr (std::is_same_v<T, uint32_t>) {
+		return FieldType::UINT32;
+	} else if constexpr (std::is_same_v<T, int64_t>) {
+		return FieldType::INT64;
+	} else if constexpr (std::is_same_v<T, uint64_t>) {
+		return FieldType::UINT64;
+	} else if constexpr (std::is_same_v<T, float>) {
+		return FieldType::FLOAT;
+	} else if constexpr (std::is_same_v<T, double>) {
+		return FieldType::DOUBLE;
+	} else if constexpr (std::is_same_v<T, Vec2f>) {
+		return FieldType::VEC2F;
+	} else if constexpr (std::is_same_v<T, Vec3f>) {
+		return FieldType::VEC3F;
+	} else if constexpr (std::is_same_v<T, Vec2u>) {
+		return FieldType::VEC2U;
+	} else if constexpr (std::is_same_v<T, Vec3u>) {
+		return FieldType::VEC3U;
+	} else if constexpr (std::is_same_v<T, Mat4>) {
+		return FieldType::MAT4;
+	} else {
+		return FieldType::BYTES;
+	}
+}
+
+/**
+ * Named member of a component at a byte offset
+ */
+struct FieldInfo {
+	std::string name;
+	FieldType type = FieldType::BYTES;
+	size_t offset = 0;
+	size_t size = 0;
+};
+
+// Describes a member of a component struct, e.g. GL_FIELD(Transform, position)
+#define GL_FIELD(type, member)                                                                     \
+	gl::FieldInfo {                                                                                \
+		#member, gl::get_field_type<decltype(type::member)>(), offsetof(type, member),             \
+				sizeof(type::member)                                                               \
+	}
+
+inline constexpr uint32_t INVALID_COMPONENT_ID = UINT32_MAX;
+
+/**
+ * Reflection metadata of a component type
+ */
+struct ComponentType {
+	uint32_t id = INVALID_COMPONENT_ID;
+	std::string name;
+	// Derived from the name, stable across builds and processes unlike id
+	uint64_t hash = 0;
+	ComponentInfo info;
+	std::vector<FieldInfo> fields;
+
+	const FieldInfo* find_field(std::string_view field_name) const;
+};
+
+/**
+ * FNV-1a hash of a component name
+ */
+uint64_t hash_component_name(std::string_view name);
+
+/**
+ * Process wide table of named component types. C++ types are registered
+ * under their get_component_id, types defined at runtime (e.g. from
+ * Python or data files) get a fresh id, after which every registry can
+ * store them through the type-erased assign and get.
+ */
+class ComponentRegistry {
+public:
+	/**
+	 * Registers T under a stable name, registering the same name again
+	 * returns the existing type
+	 */
+	template <typename T>
+	static const ComponentType& register_type(
+			std::string_view name, std::vector<FieldInfo> fields = {});
+
+	/**
+	 * Registers a plain data component only known at runtime. It is zero
+	 * initialized and relocated with memcpy.
+	 */
+	static const ComponentType& register_type(std::string_view name, size_t size,
+			size_t alignment, std::vector<FieldInfo> fields = {});
+
+	/**
+	 * Registers a plain data component laid out from its fields, offsets
+	 * of the given fields are computed with natural alignment
+	 */
+	static const ComponentType& register_type(
+			std::string_view name, std::vector<FieldInfo> fields);
+
+	static const ComponentType* find(std::string_view name);
+
+	static const ComponentType* find(uint64_t hash);
+
+	static const ComponentType* get(uint32_t component_id);
+
+	static std::vector<const ComponentType*> get_types();
+
+private:
+	static const ComponentType& _register(ComponentType type);
+};
+
+template <typename T>
+const ComponentType& ComponentRegistry::register_type(
+		std::string_view name, std::vector<FieldInfo> fields) {
+	ComponentType type;
+	type.id = get_component_id<T>();
+	type.name = name;
+	type.hash = hash_component_name(name);
+	type.fields = std::move(fields);
+
+	// Tags keep an empty layout, they are stored in masks only
+	if constexpr (!is_tag_component_v<T>) {
+		type.info = ComponentInfo::create<T>();
+	}
+
+	return _register(std::move(type));
+}
+
+} //namespace gl
@@ -0,0 +1,148 @@
+#include "core/entity_command_buffer.h"
+
+namespace gl {
+
+EntityCommandBuffer::EntityCommandBuffer() {}
+
+EntityCommandBuffer::~EntityCommandBuffer() { clear(); }
+
+Entity EntityCommandBuffer::spawn() {
+	return create_entity_id(PENDING_INDEX_BIT | _spawn_count++, 0);
+}
+
+void EntityCommandBuffer::despawn(Entity entity) {
+	Command command = {};
+	command.type = CommandType::DESPAWN;
+	command.entity = entity;
+
+	_commands.push_back(command);
+}
+
+bool EntityCommandBuffer::is_empty() const { return _commands.empty() && _spawn_count == 0; }
+
+void EntityCommandBuffer::clear() {
+	for (const Command& command : _commands) {
+		if (command.discard) {
+			command.discard(command.payload);
+		}
+	}
+
+	_commands.clear();
+	_spawn_count = 0;
+	_spawned.clear();
+
+	// Keep the first block around for the next frame
+	if (_blocks.size() > 1) {
+		_blocks.resize(1);
+	}
+	_block_offset = _blocks.empty() ? BLOCK_SIZE : 0;
+}
+
+void EntityCommandBuffer::apply(Registry& registry) {
+	EntityCommandBuffer* buffers[] = { this };
+	apply(registry, buffers);
+}
+
+void EntityCommandBuffer::apply(Registry& registry, std::span<EntityCommandBuffer* const> buffers) {
+	struct PendingCommand {
+		Command* command;
+		Entity entity;
+	};
+
+	std::vector<PendingCommand> pending;
+
+	for (EntityCommandBuffer* buffer : buffers) {
+		// Materialize spawned entities in recording order
+		buffer->_spawned.resize(buffer->_spawn_count);
+		registry.spawn_many(buffer->_spawned);
+
+		for (Command& command : buffer->_commands) {
+			pending.push_back({ &command, buffer->_resolve(command.entity) });
+		}
+	}
+
+	// Group component changes per pool and entity, despawns go last. The
+	// sort is stable so commands on the same component of the same entity
+	// keep their recording order.
+	std::stable_sort(pending.begin(), pending.end(),
+			[](const PendingCommand& lhs, const PendingCommand& rhs) {
+				const bool lhs_despawn = lhs.command->type == CommandType::DESPAWN;
+				const bool rhs_despawn = rhs.command->type == CommandType::DESPAWN;
+				if (lhs_despawn != rhs_despawn) {
+					return rhs_despawn;
+				}
+
+				if (lhs.command->component_id != rhs.command->component_id) {
+					return lhs.command->component_id < rhs.command->component_id;
+				}
+
+				return get_entity_index(lhs.entity) < get_entity_index(rhs.entity);
+			});
+
+	uint32_t reserved_component = UINT32_MAX;
+
+	for (size_t i = 0; i < pending.size(); i++) {
+		Command& command = *pending[i].command;
+
+		switch (command.type) {
+			case CommandType::ASSIGN: {
+				// Grow the pool once for the whole run of assignments
+				if (reserved_component != command.component_id) {
+					reserved_component = command.component_id;
+
+					uint32_t additional = 0;
+					for (size_t j = i; j < pending.size() &&
+							pending[j].command->component_id == command.component_id;
+							j++) {
+						additional += pending[j].command->type == CommandType::ASSIGN;
+					}
+
+					command.reserve(registry, additional);
+				}
+
+				command.apply(registry, pending[i].entity, command.payload);
+				// Payload has been consumed
+				command.discard = nullptr;
+				break;
+			}
+			case CommandType::REMOVE:
+				registry.remove(pending[i].entity, command.component_id);
+				break;
+			case CommandType::DESPAWN:
+				registry.despawn(pending[i].entity);
+				break;
+		}
+	}
+
+	for (EntityCommandBuffer* buffer : buffers) {
+		buffer->clear();
+	}
+}
+
+bool EntityCommandBuffer::is_pending(Entity entity) {
+	return get_entity_index(entity) != UINT32_MAX &&
+			(get_entity_index(entity) & PENDING_INDEX_BIT) != 0;
+}
+
+void* EntityCommandBuffer::_allocate(size_t size, size_t alignment) {
+	size_t offset = (_block_offset + alignment - 1) & ~(alignment - 1);
+
+	if (offset + size > BLOCK_SIZE || _blocks.empty()) {
+		// Oversized payloads get a dedicated block
+		_blocks.push_back(std::make_unique<uint8_t[]>(std::max(size, BLOCK_SIZE)));
+		offset = 0;
+	}
+
+	_block_offset = offset + size;
+	return _blocks.back().get() + offset;
+}
+
+Entity EntityCommandBuffer::_resolve(Entity entity) const {
+	if (!is_pending(entity)) {
+		return entity;
+	}
+
+	return _spawned[get_entity_index(entity) & ~PENDING_INDEX_BIT];
+}
+
+} //namespace gl
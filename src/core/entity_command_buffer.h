@@ -0,0 +1,132 @@
+#pragma once
+
+#include "core/registry.h"
+
+namespace gl {
+
+/**
+ * Records structural changes (spawn, despawn, assign, remove) so that they
+ * can be applied later at a sync point instead of mutating the registry
+ * while it is being iterated. A buffer must only be recorded into from a
+ * single thread, use Registry::get_command_buffer to get one per thread.
+ */
+class EntityCommandBuffer {
+public:
+	// Marks entity indices referring to entities spawned by the buffer
+	static constexpr uint32_t PENDING_INDEX_BIT = 1u << 31;
+
+	EntityCommandBuffer();
+	~EntityCommandBuffer();
+
+	EntityCommandBuffer(const EntityCommandBuffer&) = delete;
+	EntityCommandBuffer& operator=(const EntityCommandBuffer&) = delete;
+
+	/**
+	 * Queues creation of an entity and returns a placeholder for it, which
+	 * can be used in subsequent commands of this buffer only
+	 */
+	Entity spawn();
+
+	void despawn(Entity entity);
+
+	/**
+	 * Queues assignment of the component with the given value
+	 */
+	template <typename T> void assign(Entity entity, T component = {});
+
+	template <typename T> void remove(Entity entity);
+
+	bool is_empty() const;
+
+	/**
+	 * Discards every recorded command
+	 */
+	void clear();
+
+	/**
+	 * Applies the recorded commands to the registry and clears the buffer
+	 */
+	void apply(Registry& registry);
+
+	/**
+	 * Applies the commands of all buffers as a single batch. Spawns are
+	 * materialized first, component changes are sorted by component type
+	 * and entity so that each pool is touched once, and despawns come last.
+	 */
+	static void apply(Registry& registry, std::span<EntityCommandBuffer* const> buffers);
+
+	static bool is_pending(Entity entity);
+
+private:
+	enum class CommandType : uint8_t {
+		ASSIGN,
+		REMOVE,
+		DESPAWN,
+	};
+
+	typedef void (*ApplyFunc)(Registry& registry, Entity entity, void* payload);
+	typedef void (*ReserveFunc)(Registry& registry, uint32_t additional);
+	typedef void (*DiscardFunc)(void* payload);
+
+	struct Command {
+		CommandType type;
+		uint32_t component_id;
+		Entity entity;
+		void* payload;
+		ApplyFunc apply;
+		ReserveFunc reserve;
+		DiscardFunc discard;
+	};
+
+	void* _allocate(size_t size, size_t alignment);
+
+	Entity _resolve(Entity entity) const;
+
+private:
+	static constexpr size_t BLOCK_SIZE = 4096;
+
+	std::vector<Command> _commands;
+	uint32_t _spawn_count = 0;
+
+	// Entities materialized for pending placeholders during apply
+	std::vector<Entity> _spawned;
+
+	// Bump allocator for component payloads
+	std::vector<std::unique_ptr<uint8_t[]>> _blocks;
+	size_t _block_offset = BLOCK_SIZE;
+};
+
+template <typename T> void EntityCommandBuffer::assign(Entity entity, T component) {
+	void* payload = _allocate(sizeof(T), alignof(T));
+	new (payload) T(std::move(component));
+
+	Command command = {};
+	command.type = CommandType::ASSIGN;
+	command.component_id = get_component_id<T>();
+	command.entity = entity;
+	command.payload = payload;
+	command.apply = [](Registry& registry, Entity entity, void* payload) {
+		T* src = static_cast<T*>(payload);
+		if (T* dst = registry.assign<T>(entity)) {
+			*dst = std::move(*src);
+		}
+		std::destroy_at(src);
+	};
+	command.reserve = [](Registry& registry, uint32_t additional) {
+		registry.reserve<T>(registry.count<T>() + additional);
+	};
+	command.discard = [](void* payload) { std::destroy_at(static_cast<T*>(payload)); };
+
+	_commands.push_back(command);
+}
+
+template <typename T> void EntityCommandBuffer::remove(Entity entity) {
+	Command command = {};
+	command.type = CommandType::REMOVE;
+	command.component_id = get_component_id<T>();
+	command.entity = entity;
+
+	_commands.push_back(command);
+}
+
+} //namespace gl
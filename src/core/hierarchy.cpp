@@ -0,0 +1,123 @@
+#include "core/hierarchy.h"
+
+#include "core/assert.h"
+
+namespace gl {
+
+static void _detach_from_parent(Registry& registry, Entity child) {
+	Parent* parent = registry.get<Parent>(child);
+	if (!parent) {
+		return;
+	}
+
+	Children* children = registry.get<Children>(parent->entity);
+	if (children) {
+		// Drops children despawned without despawn_recursive as well
+		std::erase_if(children->entities,
+				[&](Entity entity) { return entity == child || !registry.is_valid(entity); });
+		if (children->entities.empty()) {
+			registry.remove<Children>(parent->entity);
+		}
+	}
+}
+
+void set_parent(Registry& registry, Entity child, Entity parent) {
+	if (!registry.is_valid(child)) {
+		return;
+	}
+
+	if (get_parent(registry, child) == parent) {
+		return;
+	}
+
+	_detach_from_parent(registry, child);
+
+	if (!registry.is_valid(parent)) {
+		registry.remove<Parent>(child);
+		return;
+	}
+
+	for (Entity ancestor = parent; ancestor != INVALID_ENTITY_ID;
+			ancestor = get_parent(registry, ancestor)) {
+		GL_ASSERT(ancestor != child, "An entity can not be parented to its own descendant.");
+	}
+
+	// Pointers are fetched right before use, in archetype mode assigning
+	// may move rows of other entities
+	if (!registry.has<Parent>(child)) {
+		registry.assign<Parent>(child);
+	}
+	registry.get<Parent>(child)->entity = parent;
+	registry.mark_changed<Parent>(child);
+
+	if (!registry.has<Children>(parent)) {
+		registry.assign<Children>(parent);
+	}
+	std::vector<Entity>& siblings = registry.get<Children>(parent)->entities;
+	std::erase_if(siblings, [&](Entity entity) { return !registry.is_valid(entity); });
+	siblings.push_back(child);
+}
+
+Entity get_parent(Registry& registry, Entity entity) {
+	const Parent* parent = registry.get<const Parent>(entity);
+	if (!parent || !registry.is_valid(parent->entity)) {
+		return INVALID_ENTITY_ID;
+	}
+
+	return parent->entity;
+}
+
+void despawn_recursive(Registry& registry, Entity entity) {
+	if (!registry.is_valid(entity)) {
+		return;
+	}
+
+	_detach_from_parent(registry, entity);
+
+	std::vector<Entity> stack = { entity };
+	while (!stack.empty()) {
+		const Entity current = stack.back();
+		stack.pop_back();
+
+		if (const Children* children = registry.get<const Children>(current)) {
+			stack.insert(stack.end(), children->entities.begin(), children->entities.end());
+		}
+
+		registry.despawn(current);
+	}
+}
+
+void remap_hierarchy(Registry& registry, std::span<const EntityRemap> remap) {
+	if (remap.empty()) {
+		return;
+	}
+
+	std::unordered_map<Entity, Entity> lookup;
+	for (const EntityRemap& entry : remap) {
+		lookup[entry.from] = entry.to;
+	}
+
+	const auto translate = [&](Entity& entity) {
+		const auto it = lookup.find(entity);
+		if (it == lookup.end()) {
+			return false;
+		}
+
+		entity = it->second;
+		return true;
+	};
+
+	registry.each<Parent>([&](Entity entity, Parent& parent) {
+		if (translate(parent.entity)) {
+			registry.mark_changed<Parent>(entity);
+		}
+	});
+
+	registry.each<Children>([&](Entity entity, Children& children) {
+		for (Entity& child : children.entities) {
+			translate(child);
+		}
+	});
+}
+
+} //namespace gl
@@ -0,0 +1,49 @@
+/**
+ * @file hierarchy.h
+ */
+
+#pragma once
+
+#include "core/registry.h"
+
+namespace gl {
+
+/**
+ * Entity the transform of the owner is relative to, maintained by
+ * set_parent
+ */
+struct Parent {
+	Entity entity = INVALID_ENTITY_ID;
+};
+
+/**
+ * Direct children of the owner, maintained by set_parent
+ */
+struct Children {
+	std::vector<Entity> entities;
+};
+
+/**
+ * Attaches child to parent, detaching it from its previous parent first.
+ * Passing INVALID_ENTITY_ID detaches the child and makes it a root again.
+ * The parent must not be a descendant of the child.
+ */
+void set_parent(Registry& registry, Entity child, Entity parent);
+
+/**
+ * Parent of the entity or INVALID_ENTITY_ID if it is a root
+ */
+Entity get_parent(Registry& registry, Entity entity);
+
+/**
+ * Despawns the entity together with all of its descendants
+ */
+void despawn_recursive(Registry& registry, Entity entity);
+
+/**
+ * Translates the ids stored in Parent and Children, called by
+ * Registry::compact
+ */
+void remap_hierarchy(Registry& registry, std::span<const EntityRemap> remap);
+
+} //namespace gl
@@ -0,0 +1,168 @@
+#include "core/job_system.h"
+
+namespace gl {
+
+// Queue of the current thread if it is a worker of the pool
+static thread_local const JobSystem* s_owner = nullptr;
+static thread_local uint32_t s_queue_idx = 0;
+
+JobSystem::JobSystem(uint32_t thread_count) {
+	if (thread_count == AUTO_THREAD_COUNT) {
+		thread_count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	for (uint32_t i = 0; i < thread_count + 1; i++) {
+		_queues.push_back(std::make_unique<JobQueue>());
+	}
+
+	for (uint32_t i = 0; i < thread_count; i++) {
+		_threads.emplace_back(&JobSystem::_worker_loop, this, i);
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(_wake_mutex);
+		_running = false;
+	}
+	_wake_cv.notify_all();
+
+	for (std::thread& thread : _threads) {
+		thread.join();
+	}
+}
+
+std::shared_ptr<JobSystem> JobSystem::get_shared() {
+	static const std::shared_ptr<JobSystem> s_shared = std::make_shared<JobSystem>();
+	return s_shared;
+}
+
+uint32_t JobSystem::get_thread_count() const { return _threads.size(); }
+
+void JobSystem::parallel_for(uint32_t count, uint32_t chunk_size, const RangeFunc& fn) {
+	if (count == 0) {
+		return;
+	}
+
+	chunk_size = std::max(1u, chunk_size);
+
+	const uint32_t job_count = (count + chunk_size - 1) / chunk_size;
+
+	// Nothing to distribute, run inline
+	if (_threads.empty() || job_count == 1) {
+		for (uint32_t begin = 0; begin < count; begin += chunk_size) {
+			fn(begin, std::min(begin + chunk_size, count));
+		}
+		return;
+	}
+
+	Batch batch;
+	batch.remaining = job_count;
+
+	{
+		std::lock_guard<std::mutex> lock(_wake_mutex);
+		_pending += job_count;
+	}
+
+	// Deal the jobs round-robin so that every worker starts with local work
+	for (uint32_t job_idx = 0; job_idx < job_count; job_idx++) {
+		const uint32_t begin = job_idx * chunk_size;
+		const Job job = { &fn, begin, std::min(begin + chunk_size, count), &batch };
+
+		JobQueue& queue = *_queues[job_idx % _queues.size()];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+	_wake_cv.notify_all();
+
+	// Help out until all of our jobs are done
+	const uint32_t queue_idx = _get_current_queue();
+	while (batch.remaining.load(std::memory_order_acquire) > 0) {
+		Job job;
+		if (_pop(queue_idx, job) || _steal(queue_idx, job)) {
+			_execute(job);
+		} else {
+			std::this_thread::yield();
+		}
+	}
+
+	if (batch.error) {
+		std::rethrow_exception(batch.error);
+	}
+}
+
+void JobSystem::_worker_loop(uint32_t queue_idx) {
+	s_owner = this;
+	s_queue_idx = queue_idx;
+
+	while (true) {
+		Job job;
+		if (_pop(queue_idx, job) || _steal(queue_idx, job)) {
+			_execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_wake_mutex);
+		_wake_cv.wait(lock, [this]() { return !_running || _pending.load() > 0; });
+
+		if (!_running) {
+			return;
+		}
+	}
+}
+
+bool JobSystem::_pop(uint32_t queue_idx, Job& job) {
+	JobQueue& queue = *_queues[queue_idx];
+
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.jobs.empty()) {
+		return false;
+	}
+
+	job = queue.jobs.front();
+	queue.jobs.pop_front();
+	_pending--;
+
+	return true;
+}
+
+bool JobSystem::_steal(uint32_t thief_idx, Job& job) {
+	for (uint32_t offset = 1; offset < _queues.size(); offset++) {
+		JobQueue& queue = *_queues[(thief_idx + offset) % _queues.size()];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty()) {
+			continue;
+		}
+
+		job = queue.jobs.back();
+		queue.jobs.pop_back();
+		_pending--;
+
+		return true;
+	}
+
+	return false;
+}
+
+void JobSystem::_execute(const Job& job) {
+	// Kept for the submitting thread, which waits for every job regardless
+	try {
+		(*job.fn)(job.begin, job.end);
+	} catch (...) {
+		std::lock_guard<std::mutex> lock(job.batch->error_mutex);
+		if (!job.batch->error) {
+			job.batch->error = std::current_exception();
+		}
+	}
+
+	job.batch->remaining.fetch_sub(1, std::memory_order_release);
+}
+
+uint32_t JobSystem::_get_current_queue() const {
+	// External threads share the last queue
+	return s_owner == this ? s_queue_idx : _queues.size() - 1;
+}
+
+} //namespace gl
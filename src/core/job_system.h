@@ -0,0 +1,81 @@
+#pragma once
+
+namespace gl {
+
+/**
+ * Work-stealing thread pool. Every worker owns a job queue it pops from the
+ * front of, and steals from the back of the other queues once it runs dry.
+ * Threads submitting work participate in executing it until it completes.
+ */
+class JobSystem {
+public:
+	typedef std::function<void(uint32_t begin, uint32_t end)> RangeFunc;
+
+	// Use one worker per hardware thread besides the calling thread
+	static constexpr uint32_t AUTO_THREAD_COUNT = UINT32_MAX;
+
+	JobSystem(uint32_t thread_count = AUTO_THREAD_COUNT);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	/**
+	 * Process wide pool with AUTO_THREAD_COUNT workers, created on first
+	 * use and used by every World not given its own
+	 */
+	static std::shared_ptr<JobSystem> get_shared();
+
+	uint32_t get_thread_count() const;
+
+	/**
+	 * Splits [0, count) into ranges of chunk_size elements and invokes
+	 * fn(begin, end) for each of them across the pool. Range boundaries
+	 * only depend on count and chunk_size, never on the thread count.
+	 * Blocks until every range has been processed, the first exception
+	 * thrown by fn is then rethrown on the calling thread.
+	 */
+	void parallel_for(uint32_t count, uint32_t chunk_size, const RangeFunc& fn);
+
+private:
+	// State of a single parallel_for shared by its jobs
+	struct Batch {
+		std::atomic_uint32_t remaining;
+		std::mutex error_mutex;
+		std::exception_ptr error;
+	};
+
+	struct Job {
+		const RangeFunc* fn;
+		uint32_t begin;
+		uint32_t end;
+		Batch* batch;
+	};
+
+	struct JobQueue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void _worker_loop(uint32_t queue_idx);
+
+	bool _pop(uint32_t queue_idx, Job& job);
+
+	bool _steal(uint32_t thief_idx, Job& job);
+
+	void _execute(const Job& job);
+
+	uint32_t _get_current_queue() const;
+
+private:
+	std::vector<std::thread> _threads;
+	// One queue per worker plus a shared one for external threads
+	std::vector<std::unique_ptr<JobQueue>> _queues;
+
+	std::mutex _wake_mutex;
+	std::condition_variable _wake_cv;
+	std::atomic_uint32_t _pending = 0;
+	bool _running = true;
+};
+
+} //namespace gl
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "core/assert.h"
+
+namespace gl {
+
+/**
+ * Growable array of plain data stored in fixed-size pages. Copying the
+ * array shares its pages, a page is only duplicated once either side
+ * writes to it (copy-on-write), so copies cost O(pages touched). Reads go
+ * through operator[], writes through get_writable.
+ */
+template <typename T> class PagedArray {
+	static_assert(std::is_trivially_copyable_v<T>, "Paged arrays only hold plain data");
+
+public:
+	static constexpr size_t PAGE_SIZE = 1024;
+
+	size_t size() const { return _size; }
+
+	bool empty() const { return _size == 0; }
+
+	const T& operator[](size_t idx) const { return _pages[idx / PAGE_SIZE][idx % PAGE_SIZE]; }
+
+	const T& back() const { return (*this)[_size - 1]; }
+
+	/**
+	 * Mutable access to the element, copies its page if it is shared
+	 */
+	T& get_writable(size_t idx) {
+		_detach_page(idx / PAGE_SIZE);
+		return _pages[idx / PAGE_SIZE][idx % PAGE_SIZE];
+	}
+
+	void push_back(const T& value) {
+		resize(_size + 1);
+		get_writable(_size - 1) = value;
+	}
+
+	/**
+	 * Added elements are value initialized
+	 */
+	void resize(size_t size) {
+		// Pages are allocated value initialized, only the tail left over
+		// by shrinking needs to be reset
+		const size_t page_end = std::min(size, _pages.size() * PAGE_SIZE);
+		for (size_t idx = _size; idx < page_end; idx++) {
+			get_writable(idx) = T();
+		}
+
+		while (_pages.size() * PAGE_SIZE < size) {
+			_pages.push_back(_allocate_page());
+		}
+
+		_size = size;
+	}
+
+	void reserve(size_t capacity) { _pages.reserve((capacity + PAGE_SIZE - 1) / PAGE_SIZE); }
+
+	void clear() {
+		_pages.clear();
+		_size = 0;
+	}
+
+	/**
+	 * Releases the pages past the last element
+	 */
+	void shrink_to_fit() {
+		_pages.resize((_size + PAGE_SIZE - 1) / PAGE_SIZE);
+		_pages.shrink_to_fit();
+	}
+
+	size_t get_page_count() const { return _pages.size(); }
+
+	/**
+	 * Elements [page_idx * PAGE_SIZE, (page_idx + 1) * PAGE_SIZE)
+	 */
+	const T* get_page(size_t page_idx) const { return _pages[page_idx].get(); }
+
+	/**
+	 * Takes private ownership of every shared page, so that concurrent
+	 * writers don't race on copying the same page
+	 */
+	void detach() {
+		for (size_t page_idx = 0; page_idx < _pages.size(); page_idx++) {
+			_detach_page(page_idx);
+		}
+	}
+
+	uint32_t get_shared_page_count() const {
+		return std::count_if(_pages.begin(), _pages.end(),
+				[](const std::shared_ptr<T[]>& page) { return page.use_count() > 1; });
+	}
+
+	size_t get_bytes_reserved() const {
+		return _pages.capacity() * sizeof(_pages[0]) + _pages.size() * PAGE_SIZE * sizeof(T);
+	}
+
+private:
+	static std::shared_ptr<T[]> _allocate_page() {
+		return std::shared_ptr<T[]>(new T[PAGE_SIZE]());
+	}
+
+	void _detach_page(size_t page_idx) {
+		GL_ASSERT(page_idx < _pages.size(), "Paged array index out of range");
+
+		if (_pages[page_idx].use_count() == 1) {
+			return;
+		}
+
+		std::shared_ptr<T[]> page = _allocate_page();
+		std::copy_n(_pages[page_idx].get(), PAGE_SIZE, page.get());
+		_pages[page_idx] = std::move(page);
+	}
+
+private:
+	std::vector<std::shared_ptr<T[]>> _pages;
+	size_t _size = 0;
+};
+
+} //namespace gl
@@ -0,0 +1,370 @@
+#include "core/profiler.h"
+
+#include "core/log.h"
+
+namespace gl {
+
+static std::atomic<uint32_t> s_thread_counter = 0;
+
+uint32_t get_thread_index() {
+	static thread_local const uint32_t s_thread_idx = s_thread_counter++;
+	return s_thread_idx;
+}
+
+void append_json_escaped(std::string& out, std::string_view text) {
+	for (const char c : text) {
+		switch (c) {
+			case '"':
+				out += "\\\"";
+				break;
+			case '\\':
+				out += "\\\\";
+				break;
+			case '\n':
+				out += "\\n";
+				break;
+			default:
+				if (static_cast<uint8_t>(c) < 0x20) {
+					out += std::format("\\u{:04x}", c);
+				} else {
+					out += c;
+				}
+				break;
+		}
+	}
+}
+
+// Nearest rank percentile of sorted samples
+static double _get_percentile(const std::vector<int64_t>& sorted, double percentile) {
+	const size_t rank = std::ceil(percentile * sorted.size());
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1] / 1e6;
+}
+
+Profiler::Profiler() : _epoch(Clock::now()) {}
+
+void Profiler::set_enabled(bool enabled, uint32_t history_size) {
+	_enabled = enabled;
+
+	history_size = std::max(1u, history_size);
+	if (history_size != _history_size) {
+		_history_size = history_size;
+		clear();
+
+		for (Track& track : _tracks) {
+			track.samples.clear();
+		}
+	}
+
+	// Allocated up front, recording never allocates
+	if (_enabled) {
+		for (Track& track : _tracks) {
+			track.samples.resize(_history_size);
+		}
+	}
+}
+
+uint32_t Profiler::add_track(std::string name) {
+	Track& track = _tracks.emplace_back();
+	track.name = std::move(name);
+	if (_enabled) {
+		track.samples.resize(_history_size);
+	}
+
+	return _tracks.size() - 1;
+}
+
+uint32_t Profiler::get_track_count() const { return _tracks.size(); }
+
+void Profiler::record(uint32_t track_idx, Clock::time_point start, Clock::time_point end) {
+	Track& track = _tracks[track_idx];
+	if (track.samples.empty()) {
+		return;
+	}
+
+	track.samples[track.next] = {
+		std::chrono::duration_cast<std::chrono::nanoseconds>(start - _epoch).count(),
+		std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+		get_thread_index(),
+	};
+
+	track.next = (track.next + 1) % track.samples.size();
+	track.count = std::min<uint32_t>(track.count + 1, track.samples.size());
+}
+
+TimingStats Profiler::get_stats(uint32_t track_idx) const {
+	const Track& track = _tracks[track_idx];
+
+	TimingStats stats;
+	stats.name = track.name;
+	stats.sample_count = track.count;
+
+	if (track.count == 0) {
+		return stats;
+	}
+
+	std::vector<int64_t> durations;
+	durations.reserve(track.count);
+
+	// The oldest sample sits at next once the ring is full
+	const uint32_t first = track.count < track.samples.size() ? 0 : track.next;
+	for (uint32_t i = 0; i < track.count; i++) {
+		durations.push_back(track.samples[(first + i) % track.samples.size()].duration_ns);
+	}
+
+	stats.last_ms = durations.back() / 1e6;
+	stats.mean_ms = std::accumulate(durations.begin(), durations.end(), 0.0) / 1e6 /
+			durations.size();
+
+	std::sort(durations.begin(), durations.end());
+	stats.p50_ms = _get_percentile(durations, 0.50);
+	stats.p95_ms = _get_percentile(durations, 0.95);
+	stats.p99_ms = _get_percentile(durations, 0.99);
+	stats.max_ms = durations.back() / 1e6;
+
+	return stats;
+}
+
+std::vector<TimingStats> Profiler::get_all_stats() const {
+	std::vector<TimingStats> stats;
+	stats.reserve(_tracks.size());
+	for (uint32_t i = 0; i < _tracks.size(); i++) {
+		stats.push_back(get_stats(i));
+	}
+
+	return stats;
+}
+
+void Profiler::clear() {
+	// Buffers are kept, recording goes on if enabled
+	for (Track& track : _tracks) {
+		track.next = 0;
+		track.count = 0;
+	}
+}
+
+std::string Profiler::to_chrome_trace() const {
+	std::string json = "{\"traceEvents\":[";
+
+	bool first = true;
+	for (const Track& track : _tracks) {
+		for (uint32_t i = 0; i < track.count; i++) {
+			const Sample& sample = track.samples[i];
+
+			json += first ? "\n" : ",\n";
+			first = false;
+
+			// Complete events, timestamps in microseconds
+			json += "{\"name\":\"";
+			append_json_escaped(json, track.name);
+			json += std::format("\",\"cat\":\"system\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},"
+								"\"pid\":0,\"tid\":{}}}",
+					sample.start_ns / 1e3, sample.duration_ns / 1e3, sample.thread_idx);
+		}
+	}
+
+	json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return json;
+}
+
+namespace {
+
+struct TraceEvent {
+	const char* name;
+	int64_t start_ns;
+	int64_t duration_ns;
+};
+
+// Single producer, single consumer ring, head is only written by the
+// owning thread and tail only by the flushing one
+struct TraceBuffer {
+	std::array<TraceEvent, Tracer::BUFFER_SIZE> events;
+	std::atomic<uint64_t> head = 0;
+	std::atomic<uint64_t> tail = 0;
+	uint32_t thread_idx = 0;
+	// Owning thread exited, reusable once drained
+	bool released = false;
+};
+
+} //namespace
+
+static const Profiler::Clock::time_point s_trace_epoch = Profiler::Clock::now();
+
+// Guards everything but the contents of the buffers
+static std::mutex s_trace_mutex;
+// Kept after their threads exit so their last events still get flushed
+static std::vector<std::unique_ptr<TraceBuffer>> s_trace_buffers;
+static std::vector<TraceBuffer*> s_free_trace_buffers;
+static std::ofstream s_trace_file;
+static bool s_trace_empty = true;
+static std::atomic<uint64_t> s_trace_dropped = 0;
+
+static void _recycle_trace_buffer(TraceBuffer& buffer) {
+	buffer.released = false;
+	s_free_trace_buffers.push_back(&buffer);
+}
+
+namespace {
+
+// Hands the buffer back when its thread exits
+struct TraceBufferHandle {
+	TraceBuffer* buffer = nullptr;
+
+	~TraceBufferHandle() {
+		if (!buffer) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(s_trace_mutex);
+
+		// Events left without a trace to write them to get discarded by start
+		if (!s_trace_file.is_open() ||
+				buffer->tail.load(std::memory_order_relaxed) == buffer->head.load()) {
+			_recycle_trace_buffer(*buffer);
+		} else {
+			buffer->released = true;
+		}
+	}
+};
+
+} //namespace
+
+static TraceBuffer& _get_trace_buffer() {
+	static thread_local TraceBufferHandle s_handle;
+	if (!s_handle.buffer) {
+		std::lock_guard<std::mutex> lock(s_trace_mutex);
+
+		if (!s_free_trace_buffers.empty()) {
+			s_handle.buffer = s_free_trace_buffers.back();
+			s_free_trace_buffers.pop_back();
+		} else {
+			s_handle.buffer = s_trace_buffers.emplace_back(std::make_unique<TraceBuffer>()).get();
+		}
+
+		s_handle.buffer->thread_idx = get_thread_index();
+	}
+
+	return *s_handle.buffer;
+}
+
+static void _flush_trace_buffers() {
+	std::string json;
+
+	for (auto& buffer : s_trace_buffers) {
+		const uint64_t head = buffer->head.load(std::memory_order_acquire);
+		const uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+
+		for (uint64_t i = tail; i < head; i++) {
+			const TraceEvent& event = buffer->events[i % Tracer::BUFFER_SIZE];
+
+			json += s_trace_empty ? "\n" : ",\n";
+			s_trace_empty = false;
+
+			json += "{\"name\":\"";
+			append_json_escaped(json, event.name);
+			json += std::format("\",\"cat\":\"scope\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},"
+								"\"pid\":0,\"tid\":{}}}",
+					event.start_ns / 1e3, event.duration_ns / 1e3, buffer->thread_idx);
+		}
+
+		buffer->tail.store(head, std::memory_order_release);
+
+		if (buffer->released) {
+			_recycle_trace_buffer(*buffer);
+		}
+	}
+
+	s_trace_file << json;
+}
+
+bool Tracer::start(const std::string& path) {
+	std::lock_guard<std::mutex> lock(s_trace_mutex);
+
+	if (s_trace_file.is_open()) {
+		s_enabled = false;
+		s_trace_file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+		s_trace_file.close();
+	}
+
+	s_trace_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!s_trace_file) {
+		GL_LOG_ERROR("Unable to open trace file '{}'", path);
+		return false;
+	}
+
+	// Leftovers of a previous trace
+	for (auto& buffer : s_trace_buffers) {
+		buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+
+		if (buffer->released) {
+			_recycle_trace_buffer(*buffer);
+		}
+	}
+
+	s_trace_file << "{\"traceEvents\":[";
+	s_trace_empty = true;
+	s_trace_dropped = 0;
+	s_enabled = true;
+
+	return true;
+}
+
+void Tracer::stop() {
+	std::lock_guard<std::mutex> lock(s_trace_mutex);
+
+	if (!s_trace_file.is_open()) {
+		return;
+	}
+
+	s_enabled = false;
+
+	_flush_trace_buffers();
+	s_trace_file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	s_trace_file.close();
+}
+
+void Tracer::flush() {
+	std::lock_guard<std::mutex> lock(s_trace_mutex);
+
+	if (s_trace_file.is_open()) {
+		_flush_trace_buffers();
+	}
+}
+
+uint64_t Tracer::get_dropped_count() { return s_trace_dropped; }
+
+size_t Tracer::get_buffer_count() {
+	std::lock_guard<std::mutex> lock(s_trace_mutex);
+	return s_trace_buffers.size();
+}
+
+void Tracer::record(
+		const char* name, Profiler::Clock::time_point start, Profiler::Clock::time_point end) {
+	TraceBuffer& buffer = _get_trace_buffer();
+
+	const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+	if (head - buffer.tail.load(std::memory_order_acquire) >= BUFFER_SIZE) {
+		s_trace_dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	buffer.events[head % BUFFER_SIZE] = {
+		name,
+		std::chrono::duration_cast<std::chrono::nanoseconds>(start - s_trace_epoch).count(),
+		std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+	};
+
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+bool Profiler::write_chrome_trace(const std::string& path) const {
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		GL_LOG_ERROR("Unable to open trace file '{}'", path);
+		return false;
+	}
+
+	file << to_chrome_trace();
+	return file.good();
+}
+
+} //namespace gl
@@ -0,0 +1,183 @@
+/**
+ * @file profiler.h
+ */
+
+#pragma once
+
+namespace gl {
+
+/**
+ * Summary of the samples a track currently holds, in milliseconds
+ */
+struct TimingStats {
+	std::string name;
+	uint32_t sample_count = 0;
+	double last_ms = 0.0;
+	double mean_ms = 0.0;
+	double p50_ms = 0.0;
+	double p95_ms = 0.0;
+	double p99_ms = 0.0;
+	double max_ms = 0.0;
+};
+
+/**
+ * Small stable index of the calling thread, used as trace thread id
+ */
+uint32_t get_thread_index();
+
+/**
+ * Named timing tracks keeping a rolling window of their latest samples.
+ * Every track must only be recorded to from one thread at a time, while
+ * different tracks may be recorded to concurrently.
+ */
+class Profiler {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	static constexpr uint32_t DEFAULT_HISTORY_SIZE = 256;
+
+	Profiler();
+
+	/**
+	 * Samples are only recorded while enabled, changing the history size
+	 * drops the recorded ones
+	 */
+	void set_enabled(bool enabled, uint32_t history_size = DEFAULT_HISTORY_SIZE);
+
+	bool is_enabled() const { return _enabled; }
+
+	uint32_t add_track(std::string name);
+
+	uint32_t get_track_count() const;
+
+	void record(uint32_t track_idx, Clock::time_point start, Clock::time_point end);
+
+	TimingStats get_stats(uint32_t track_idx) const;
+
+	std::vector<TimingStats> get_all_stats() const;
+
+	/**
+	 * Drops the recorded samples, recording continues if enabled
+	 */
+	void clear();
+
+	/**
+	 * Samples of every track as Chrome trace event JSON, loadable in
+	 * chrome://tracing and Perfetto
+	 */
+	std::string to_chrome_trace() const;
+
+	bool write_chrome_trace(const std::string& path) const;
+
+private:
+	struct Sample {
+		int64_t start_ns;
+		int64_t duration_ns;
+		uint32_t thread_idx;
+	};
+
+	struct Track {
+		std::string name;
+		// Ring buffer, next is the slot written next
+		std::vector<Sample> samples;
+		uint32_t next = 0;
+		uint32_t count = 0;
+	};
+
+	bool _enabled = false;
+	uint32_t _history_size = DEFAULT_HISTORY_SIZE;
+	Clock::time_point _epoch;
+	std::vector<Track> _tracks;
+};
+
+/**
+ * Process wide recorder of GL_PROFILE_SCOPE events. Every thread records
+ * into a ring buffer of its own without locking, flush drains them into
+ * the Chrome trace event file given to start. Events of a thread that
+ * can't be flushed in time are dropped.
+ */
+class Tracer {
+public:
+	// Events every thread can hold between two flushes
+	static constexpr uint32_t BUFFER_SIZE = 1 << 15;
+
+	/**
+	 * Discards events recorded before, returns false if the file can't be
+	 * opened
+	 */
+	static bool start(const std::string& path);
+
+	/**
+	 * Flushes the recorded events and completes the trace file
+	 */
+	static void stop();
+
+	/**
+	 * Writes the events recorded so far to the trace file, meant to be
+	 * called once per frame. Only a single thread flushes at a time.
+	 */
+	static void flush();
+
+	static bool is_enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+	/**
+	 * Events dropped because a buffer was full since start
+	 */
+	static uint64_t get_dropped_count();
+
+	/**
+	 * Per thread buffers allocated so far, buffers of exited threads are
+	 * reused once their events were written
+	 */
+	static size_t get_buffer_count();
+
+	/**
+	 * name must outlive the trace, e.g. a string literal
+	 */
+	static void record(const char* name, Profiler::Clock::time_point start,
+			Profiler::Clock::time_point end);
+
+private:
+	static inline std::atomic<bool> s_enabled = false;
+};
+
+/**
+ * Records the time until the end of its scope, see GL_PROFILE_SCOPE
+ */
+class ProfileScope {
+public:
+	explicit ProfileScope(const char* name) :
+			_name(Tracer::is_enabled() ? name : nullptr),
+			_start(_name ? Profiler::Clock::now() : Profiler::Clock::time_point()) {}
+
+	~ProfileScope() {
+		if (_name) {
+			Tracer::record(_name, _start, Profiler::Clock::now());
+		}
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* _name;
+	Profiler::Clock::time_point _start;
+};
+
+/**
+ * Appends text to out as the contents of a JSON string
+ */
+void append_json_escaped(std::string& out, std::string_view text);
+
+} //namespace gl
+
+#define GL_PROFILE_CONCAT_IMPL(a, b) a##b
+#define GL_PROFILE_CONCAT(a, b) GL_PROFILE_CONCAT_IMPL(a, b)
+
+// Traces the rest of the enclosing scope under a string literal name
+#ifdef GL_DIST_BUILD
+#define GL_PROFILE_SCOPE(name)
+#else
+#define GL_PROFILE_SCOPE(name)                                                                     \
+	const ::gl::ProfileScope GL_PROFILE_CONCAT(_profile_scope_, __LINE__)(name)
+#endif
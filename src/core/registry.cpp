@@ -1,136 +1,1833 @@
 #include "core/registry.h"
 
+#include "core/component_registry.h"
+#include "core/entity_command_buffer.h"
+#include "core/hierarchy.h"
+
 namespace gl {
 
-ComponentPool::ComponentPool(size_t element_size) : _element_size(element_size) {}
+static float _get_fragmentation(size_t bytes_reserved, size_t bytes_used) {
+	if (bytes_reserved == 0) {
+		return 0.0f;
+	}
+
+	return 1.0f - (float)bytes_used / (float)bytes_reserved;
+}
+
+float ComponentMemoryStats::get_fragmentation() const {
+	return _get_fragmentation(bytes_reserved, bytes_used);
+}
+
+size_t MemoryStats::get_bytes_reserved() const {
+	size_t bytes = entity_bytes_reserved;
+	for (const ComponentMemoryStats& component : components) {
+		bytes += component.bytes_reserved;
+	}
+	return bytes;
+}
+
+size_t MemoryStats::get_bytes_used() const {
+	size_t bytes = entity_bytes_used;
+	for (const ComponentMemoryStats& component : components) {
+		bytes += component.bytes_used;
+	}
+	return bytes;
+}
+
+float MemoryStats::get_fragmentation() const {
+	return _get_fragmentation(get_bytes_reserved(), get_bytes_used());
+}
+
+namespace {
+
+// Slot to rotate swapped components through, grown to the largest size and
+// alignment seen by the thread
+struct SwapScratch {
+	void* data = nullptr;
+	size_t size = 0;
+	size_t alignment = 0;
+
+	~SwapScratch() {
+		if (data) {
+			::operator delete(data, std::align_val_t(alignment));
+		}
+	}
+
+	void* reserve(size_t p_size, size_t p_alignment) {
+		p_alignment = std::max(p_alignment, alignof(std::max_align_t));
+		if (p_size > size || p_alignment > alignment) {
+			if (data) {
+				::operator delete(data, std::align_val_t(alignment));
+			}
+
+			size = std::max(p_size, size);
+			alignment = std::max(p_alignment, alignment);
+			data = ::operator new(size, std::align_val_t(alignment));
+		}
+
+		return data;
+	}
+};
+
+} //namespace
+
+void ComponentInfo::swap(void* lhs, void* rhs) const {
+	thread_local SwapScratch s_scratch;
+	void* scratch = s_scratch.reserve(size, alignment);
+
+	move_to(scratch, lhs);
+	move_to(lhs, rhs);
+	move_to(rhs, scratch);
+}
+
+ComponentPool::ComponentPool(const ComponentInfo& info) : _info(info) {}
+
+ComponentPool::~ComponentPool() {
+	if (!_info.destroy) {
+		return;
+	}
+
+	// Pages still shared with a snapshot are destroyed by their last owner
+	for (uint32_t dense_idx = 0; dense_idx < _count; dense_idx++) {
+		const auto& page = _dense_pages[dense_idx / PAGE_SIZE];
+		if (page.use_count() == 1) {
+			_info.destroy(page.get() + (dense_idx % PAGE_SIZE) * _info.size);
+		}
+	}
+}
+
+ComponentPool::ComponentPool(const ComponentPool& other) :
+		_sparse(other._sparse),
+		_entity_pages(other._entity_pages),
+		_dense_pages(other._dense_pages),
+		_count(other._count),
+		_info(other._info) {}
+
+size_t ComponentPool::get_size() const { return _info.size; }
+
+uint32_t ComponentPool::get_count() const { return _count; }
+
+bool ComponentPool::contains(uint32_t idx) const {
+	return get_dense_index(idx) != INVALID_INDEX;
+}
+
+void* ComponentPool::get(size_t idx) {
+	const uint32_t dense_idx = get_dense_index(idx);
+	if (dense_idx == INVALID_INDEX) {
+		return nullptr;
+	}
+
+	return _get_dense(dense_idx);
+}
+
+const void* ComponentPool::get(size_t idx) const {
+	const uint32_t dense_idx = get_dense_index(idx);
+	if (dense_idx == INVALID_INDEX) {
+		return nullptr;
+	}
+
+	return _dense_pages[dense_idx / PAGE_SIZE].get() + (dense_idx % PAGE_SIZE) * _info.size;
+}
+
+void* ComponentPool::emplace(Entity entity) {
+	uint32_t& dense_idx = _get_or_create_sparse(get_entity_index(entity));
+
+	// Append to the end of the dense arrays if this is a new component
+	if (dense_idx == INVALID_INDEX) {
+		dense_idx = _count;
+
+		// Allocate the next dense page if the last one is full, otherwise
+		// make sure the page isn't shared before the live range grows
+		if (dense_idx / PAGE_SIZE >= _dense_pages.size()) {
+			_push_dense_page();
+		} else {
+			_detach_dense_page(dense_idx / PAGE_SIZE);
+		}
+
+		_get_dense_entity(dense_idx) = entity;
+		_count++;
+	} else {
+		// Replace the existing component
+		_get_dense_entity(dense_idx) = entity;
+		_info.destroy_at(_get_dense(dense_idx));
+	}
+
+	return _get_dense(dense_idx);
+}
+
+void ComponentPool::remove(uint32_t idx) {
+	const uint32_t dense_idx = get_dense_index(idx);
+	if (dense_idx == INVALID_INDEX) {
+		return;
+	}
+
+	_info.destroy_at(_get_dense(dense_idx));
+
+	const uint32_t last_idx = _count - 1;
+	if (dense_idx != last_idx) {
+		// Fill the hole with the last component
+		const Entity last_entity = get_entity(last_idx);
+
+		_info.move_to(_get_dense(dense_idx), _get_dense(last_idx));
 
-ComponentPool::~ComponentPool() {}
+		_get_dense_entity(dense_idx) = last_entity;
+		_get_or_create_sparse(get_entity_index(last_entity)) = dense_idx;
+	}
+
+	_count--;
+
+	// Release the trailing dense page once it becomes empty
+	if (_count == (_dense_pages.size() - 1) * PAGE_SIZE) {
+		_dense_pages.pop_back();
+		_entity_pages.pop_back();
+	}
+
+	_get_or_create_sparse(idx) = INVALID_INDEX;
+}
+
+void ComponentPool::reserve(uint32_t capacity) {
+	while (_dense_pages.size() * PAGE_SIZE < capacity) {
+		_push_dense_page();
+	}
+}
+
+void ComponentPool::relocate(uint32_t idx, Entity entity) {
+	const uint32_t dense_idx = get_dense_index(idx);
+	if (dense_idx == INVALID_INDEX) {
+		return;
+	}
+
+	_get_dense_entity(dense_idx) = entity;
+	_get_or_create_sparse(get_entity_index(entity)) = dense_idx;
+	_get_or_create_sparse(idx) = INVALID_INDEX;
+}
+
+void ComponentPool::shrink_to_fit() {
+	for (auto& page : _sparse) {
+		if (page && std::all_of(page.get(), page.get() + PAGE_SIZE,
+							[](uint32_t dense_idx) { return dense_idx == INVALID_INDEX; })) {
+			page.reset();
+		}
+	}
+
+	while (!_sparse.empty() && !_sparse.back()) {
+		_sparse.pop_back();
+	}
+	_sparse.shrink_to_fit();
+
+	// Pages past the last component only exist because of reserve
+	const size_t page_count = (_count + PAGE_SIZE - 1) / PAGE_SIZE;
+	_dense_pages.resize(page_count);
+	_dense_pages.shrink_to_fit();
+	_entity_pages.resize(page_count);
+	_entity_pages.shrink_to_fit();
+}
+
+void ComponentPool::swap(uint32_t lhs_dense_idx, uint32_t rhs_dense_idx) {
+	if (lhs_dense_idx == rhs_dense_idx) {
+		return;
+	}
+
+	_info.swap(_get_dense(lhs_dense_idx), _get_dense(rhs_dense_idx));
+
+	const Entity lhs_entity = get_entity(lhs_dense_idx);
+	const Entity rhs_entity = get_entity(rhs_dense_idx);
+
+	_get_dense_entity(lhs_dense_idx) = rhs_entity;
+	_get_dense_entity(rhs_dense_idx) = lhs_entity;
+
+	_get_or_create_sparse(get_entity_index(rhs_entity)) = lhs_dense_idx;
+	_get_or_create_sparse(get_entity_index(lhs_entity)) = rhs_dense_idx;
+}
+
+void* ComponentPool::get_page(size_t page_idx) {
+	_detach_dense_page(page_idx);
+	return _dense_pages[page_idx].get();
+}
+
+const void* ComponentPool::get_page(size_t page_idx) const {
+	return _dense_pages[page_idx].get();
+}
+
+void ComponentPool::detach() {
+	for (size_t page_idx = 0; page_idx < _sparse.size(); page_idx++) {
+		if (_sparse[page_idx]) {
+			_get_or_create_sparse(page_idx * PAGE_SIZE);
+		}
+	}
+
+	for (size_t page_idx = 0; page_idx < _dense_pages.size(); page_idx++) {
+		_detach_dense_page(page_idx);
+		_detach_entity_page(page_idx);
+	}
+}
+
+const Entity* ComponentPool::get_entity_page(size_t page_idx) const {
+	return _entity_pages[page_idx].get();
+}
+
+ComponentMemoryStats ComponentPool::get_memory_stats() const {
+	ComponentMemoryStats stats;
+	stats.component_size = _info.size;
+	stats.count = get_count();
 
-ComponentPool::ComponentPool(const ComponentPool& other) : _element_size(other._element_size) {
-	for (const auto& page : other._pages) {
+	stats.bytes_reserved = _sparse.capacity() * sizeof(_sparse[0]) +
+			_dense_pages.capacity() * sizeof(_dense_pages[0]) +
+			_entity_pages.capacity() * sizeof(_entity_pages[0]);
+	stats.bytes_used = stats.count * (_info.size + sizeof(Entity) + sizeof(uint32_t));
+
+	for (const auto& page : _sparse) {
 		if (!page) {
 			continue;
 		}
 
-		auto new_page = std::make_unique<uint8_t[]>(PAGE_SIZE * _element_size);
-		std::memcpy(new_page.get(), page.get(), PAGE_SIZE * _element_size);
-		_pages.push_back(std::move(new_page));
+		stats.sparse_pages++;
+		stats.shared_pages += page.use_count() > 1;
+		stats.bytes_reserved += PAGE_SIZE * sizeof(uint32_t);
+	}
+
+	// Every dense page has a page of entities alongside
+	for (size_t page_idx = 0; page_idx < _dense_pages.size(); page_idx++) {
+		stats.dense_pages++;
+		stats.shared_pages += _dense_pages[page_idx].use_count() > 1;
+		stats.shared_pages += _entity_pages[page_idx].use_count() > 1;
+		stats.bytes_reserved += PAGE_SIZE * (_info.size + sizeof(Entity));
 	}
+
+	return stats;
 }
 
-size_t ComponentPool::get_size() const { return _element_size; }
+uint32_t ComponentPool::get_dense_index(uint32_t idx) const {
+	const size_t page_idx = idx / PAGE_SIZE;
+	if (page_idx >= _sparse.size() || !_sparse[page_idx]) {
+		return INVALID_INDEX;
+	}
 
-void* ComponentPool::get(size_t idx) {
+	return _sparse[page_idx][idx % PAGE_SIZE];
+}
+
+uint32_t& ComponentPool::_get_or_create_sparse(uint32_t idx) {
 	const size_t page_idx = idx / PAGE_SIZE;
-	const size_t offset = idx % PAGE_SIZE;
 
-	if (page_idx >= _pages.size() || !_pages[page_idx]) {
-		return nullptr;
+	// Ensure we have enough pages
+	if (page_idx >= _sparse.size()) {
+		_sparse.resize(page_idx + 1);
+	}
+
+	// Allocate the page if it doesn't exist
+	if (!_sparse[page_idx]) {
+		_sparse[page_idx] = std::make_shared<uint32_t[]>(PAGE_SIZE);
+		std::fill_n(_sparse[page_idx].get(), PAGE_SIZE, INVALID_INDEX);
+	} else if (_sparse[page_idx].use_count() > 1) {
+		// Shared with a snapshot, copy before writing
+		auto page = std::make_shared<uint32_t[]>(PAGE_SIZE);
+		std::memcpy(page.get(), _sparse[page_idx].get(), PAGE_SIZE * sizeof(uint32_t));
+		_sparse[page_idx] = std::move(page);
 	}
 
-	return _pages[page_idx].get() + (offset * _element_size);
+	return _sparse[page_idx][idx % PAGE_SIZE];
 }
 
-Registry::~Registry() { clear(); }
+Entity& ComponentPool::_get_dense_entity(uint32_t dense_idx) {
+	const size_t page_idx = dense_idx / PAGE_SIZE;
+	_detach_entity_page(page_idx);
 
-void Registry::clear() {
-	// Clear all data
-	_component_pools.clear();
-	_entities.clear();
-	_free_indices = {};
-	_entity_counter = 0;
+	return _entity_pages[page_idx][dense_idx % PAGE_SIZE];
 }
 
-void Registry::copy_to(Registry& dest) {
-	dest.clear();
+uint8_t* ComponentPool::_get_dense(uint32_t dense_idx) {
+	const size_t page_idx = dense_idx / PAGE_SIZE;
+	_detach_dense_page(page_idx);
 
-	// Copy trivial data
-	dest._entity_counter = _entity_counter;
-	dest._free_indices = _free_indices;
-	dest._entities = _entities; // This copies versions and component masks
+	return _dense_pages[page_idx].get() + (dense_idx % PAGE_SIZE) * _info.size;
+}
 
-	// Prepare destination pools
-	dest._component_pools.resize(_component_pools.size(), nullptr);
+void ComponentPool::_detach_dense_page(size_t page_idx) {
+	if (_dense_pages[page_idx].use_count() == 1) {
+		return;
+	}
 
-	// Iterate all pools and copy component data
-	for (size_t comid = 0; comid < _component_pools.size(); comid++) {
-		if (_component_pools[comid] == nullptr) {
-			continue; // This component type isn't used
+	const std::shared_ptr<uint8_t[]> shared = _dense_pages[page_idx];
+	std::shared_ptr<uint8_t[]> page = _allocate_dense_page();
+
+	if (_info.copy) {
+		// Only the live components of the page need to be copied
+		const uint32_t begin = page_idx * PAGE_SIZE;
+		const uint32_t end = std::min<uint32_t>(begin + PAGE_SIZE, _count);
+
+		for (uint32_t dense_idx = begin; dense_idx < end; dense_idx++) {
+			const size_t offset = (dense_idx - begin) * _info.size;
+			_info.copy(page.get() + offset, shared.get() + offset);
 		}
+	} else {
+		std::memcpy(page.get(), shared.get(), PAGE_SIZE * _info.size);
+	}
 
-		// Copy the components
-		const auto old_pool = _component_pools[comid];
-		dest._component_pools[comid] = std::make_unique<ComponentPool>(*old_pool);
+	_dense_pages[page_idx] = std::move(page);
+}
+
+void ComponentPool::_detach_entity_page(size_t page_idx) {
+	if (_entity_pages[page_idx].use_count() == 1) {
+		return;
 	}
+
+	auto page = std::make_shared<Entity[]>(PAGE_SIZE);
+	std::memcpy(page.get(), _entity_pages[page_idx].get(), PAGE_SIZE * sizeof(Entity));
+	_entity_pages[page_idx] = std::move(page);
 }
 
-Entity Registry::spawn() {
-	if (!_free_indices.empty()) {
-		uint32_t new_idx = _free_indices.front();
-		_free_indices.pop();
+std::shared_ptr<uint8_t[]> ComponentPool::_allocate_dense_page() const {
+	const std::align_val_t alignment{ std::max(_info.alignment, alignof(std::max_align_t)) };
+
+	return std::shared_ptr<uint8_t[]>(
+			static_cast<uint8_t*>(::operator new(PAGE_SIZE * _info.size, alignment)),
+			[alignment](uint8_t* page) { ::operator delete(page, alignment); });
+}
 
-		Entity new_id = create_entity_id(new_idx, get_entity_version(_entities[new_idx].id));
+void ComponentPool::_push_dense_page() {
+	_dense_pages.push_back(_allocate_dense_page());
+	_entity_pages.push_back(std::make_shared<Entity[]>(PAGE_SIZE));
+}
+
+static size_t _align_up(size_t value, size_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
 
-		_entities[new_idx].id = new_id;
+Archetype::Archetype(const ComponentMask& mask, const std::vector<ComponentInfo>& infos) :
+		_mask(mask), _column_lookup(MAX_COMPONENTS, -1) {
+	size_t row_bytes = sizeof(Entity);
+	size_t max_padding = 0;
 
-		return new_id;
+	_mask.for_each([&](uint32_t comid) {
+		// Components without a layout are pure mask bits and get no column
+		if (comid >= infos.size() || infos[comid].size == 0) {
+			return;
+		}
+
+		const ComponentInfo& info = infos[comid];
+		GL_ASSERT(info.alignment <= alignof(std::max_align_t),
+				"Over-aligned components are not supported by archetype storage");
+
+		_column_lookup[comid] = _columns.size();
+		_columns.push_back({ comid, info, 0 });
+
+		row_bytes += info.size;
+		max_padding += info.alignment;
+	});
+
+	_chunk_capacity = std::max<size_t>(1, (CHUNK_SIZE - max_padding) / row_bytes);
+
+	// Entity ids are stored first and each column follows it aligned
+	size_t offset = _chunk_capacity * sizeof(Entity);
+	for (Column& column : _columns) {
+		offset = _align_up(offset, column.info.alignment);
+		column.offset = offset;
+		offset += _chunk_capacity * column.info.size;
+	}
+
+	_chunk_bytes = offset;
+}
+
+Archetype::~Archetype() {
+	for (const Column& column : _columns) {
+		if (!column.info.destroy) {
+			continue;
+		}
+
+		// Chunks still shared with a snapshot are destroyed by their last owner
+		for (uint32_t row = 0; row < _size; row++) {
+			const auto& chunk = _chunks[row / _chunk_capacity];
+			if (chunk.use_count() == 1) {
+				column.info.destroy(chunk.get() + column.offset +
+						(row % _chunk_capacity) * column.info.size);
+			}
+		}
 	}
+}
+
+Archetype::Archetype(const Archetype& other) :
+		_mask(other._mask),
+		_columns(other._columns),
+		_column_lookup(other._column_lookup),
+		_chunk_capacity(other._chunk_capacity),
+		_chunk_bytes(other._chunk_bytes),
+		_size(other._size),
+		_chunks(other._chunks) {}
 
-	_entities.push_back({ create_entity_id(_entities.size(), 0), ComponentMask() });
+const ComponentMask& Archetype::get_mask() const { return _mask; }
 
-	return _entities.back().id;
+uint32_t Archetype::get_size() const { return _size; }
+
+uint32_t Archetype::get_chunk_capacity() const { return _chunk_capacity; }
+
+size_t Archetype::get_chunk_count() const { return _chunks.size(); }
+
+size_t Archetype::get_chunk_bytes() const { return _chunk_bytes; }
+
+uint32_t Archetype::get_chunk_size(size_t chunk_idx) const {
+	const uint32_t chunk_begin = chunk_idx * _chunk_capacity;
+	return std::min(_size - chunk_begin, _chunk_capacity);
 }
 
-bool Registry::is_valid(Entity entity) {
-	if (get_entity_index(entity) >= _entities.size()) {
-		return false;
+bool Archetype::has_column(uint32_t component_id) const {
+	return _column_lookup[component_id] != -1;
+}
+
+uint32_t Archetype::push(Entity entity) {
+	const uint32_t row = _size;
+
+	// Shared chunks are copied before their live range grows
+	if (row / _chunk_capacity >= _chunks.size()) {
+		_chunks.push_back(_allocate_chunk());
+	} else {
+		_detach_chunk(row / _chunk_capacity);
 	}
+	_size++;
+
+	Entity* entities = reinterpret_cast<Entity*>(_chunks[row / _chunk_capacity].get());
+	entities[row % _chunk_capacity] = entity;
 
-	return _entities[get_entity_index(entity)].id == entity;
+	return row;
 }
 
-void Registry::despawn(Entity entity) {
-	const uint32_t entity_idx = get_entity_index(entity);
+Entity Archetype::swap_remove(uint32_t row) {
+	const uint32_t last = _size - 1;
 
-	Entity new_entity_id = create_entity_id(UINT32_MAX, get_entity_version(entity) + 1);
+	_detach_chunk(row / _chunk_capacity);
+	_detach_chunk(last / _chunk_capacity);
+
+	Entity moved = INVALID_ENTITY_ID;
+	if (row != last) {
+		uint8_t* dst_chunk = _chunks[row / _chunk_capacity].get();
+		uint8_t* src_chunk = _chunks[last / _chunk_capacity].get();
+
+		const size_t dst_slot = row % _chunk_capacity;
+		const size_t src_slot = last % _chunk_capacity;
+
+		for (const Column& column : _columns) {
+			const size_t size = column.info.size;
+			column.info.move_to(dst_chunk + column.offset + dst_slot * size,
+					src_chunk + column.offset + src_slot * size);
+		}
+
+		moved = reinterpret_cast<Entity*>(src_chunk)[src_slot];
+		reinterpret_cast<Entity*>(dst_chunk)[dst_slot] = moved;
+	}
+
+	_size--;
 
-	_entities[entity_idx].id = new_entity_id;
-	_entities[entity_idx].mask.reset();
+	// Release the trailing chunk once it becomes empty
+	if (_size <= (_chunks.size() - 1) * _chunk_capacity) {
+		_chunks.pop_back();
+	}
 
-	_free_indices.push(entity_idx);
+	return moved;
 }
 
-bool Registry::assign_id(Entity entity, uint32_t component_id) {
-	if (!is_valid(entity)) {
-		return false;
+Entity Archetype::get_entity(uint32_t row) const {
+	const Entity* entities = reinterpret_cast<const Entity*>(_chunks[row / _chunk_capacity].get());
+	return entities[row % _chunk_capacity];
+}
+
+void Archetype::set_entity(uint32_t row, Entity entity) {
+	_detach_chunk(row / _chunk_capacity);
+
+	Entity* entities = reinterpret_cast<Entity*>(_chunks[row / _chunk_capacity].get());
+	entities[row % _chunk_capacity] = entity;
+}
+
+void Archetype::swap(uint32_t lhs_row, uint32_t rhs_row) {
+	if (lhs_row == rhs_row) {
+		return;
 	}
 
-	_entities[get_entity_index(entity)].mask.set(component_id);
+	_detach_chunk(lhs_row / _chunk_capacity);
+	_detach_chunk(rhs_row / _chunk_capacity);
 
-	return true;
+	uint8_t* lhs_chunk = _chunks[lhs_row / _chunk_capacity].get();
+	uint8_t* rhs_chunk = _chunks[rhs_row / _chunk_capacity].get();
+
+	const size_t lhs_slot = lhs_row % _chunk_capacity;
+	const size_t rhs_slot = rhs_row % _chunk_capacity;
+
+	for (const Column& column : _columns) {
+		const size_t size = column.info.size;
+		column.info.swap(lhs_chunk + column.offset + lhs_slot * size,
+				rhs_chunk + column.offset + rhs_slot * size);
+	}
+
+	Entity* lhs_entities = reinterpret_cast<Entity*>(lhs_chunk);
+	Entity* rhs_entities = reinterpret_cast<Entity*>(rhs_chunk);
+	std::swap(lhs_entities[lhs_slot], rhs_entities[rhs_slot]);
 }
 
-bool Registry::remove(Entity entity, uint32_t component_id) {
-	if (!is_valid(entity)) {
-		return false;
+void* Archetype::get(uint32_t component_id, uint32_t row) {
+	if (_column_lookup[component_id] == -1) {
+		return nullptr;
 	}
 
-	const uint32_t entity_idx = get_entity_index(entity);
+	_detach_chunk(row / _chunk_capacity);
+	return const_cast<void*>(std::as_const(*this).get(component_id, row));
+}
 
-	if (_entities[entity_idx].mask.test(component_id)) {
-		// TODO: destroy the component object
-		_entities[entity_idx].mask.reset(component_id);
+const void* Archetype::get(uint32_t component_id, uint32_t row) const {
+	const int32_t column_idx = _column_lookup[component_id];
+	if (column_idx == -1) {
+		return nullptr;
 	}
 
-	return true;
+	const Column& column = _columns[column_idx];
+	return _chunks[row / _chunk_capacity].get() + column.offset +
+			(row % _chunk_capacity) * column.info.size;
 }
 
-bool Registry::has(Entity entity, uint32_t component_id) {
-	if (!is_valid(entity)) {
+const Entity* Archetype::get_entities(size_t chunk_idx) const {
+	return reinterpret_cast<const Entity*>(_chunks[chunk_idx].get());
+}
+
+void* Archetype::get_column(size_t chunk_idx, uint32_t component_id) {
+	if (_column_lookup[component_id] == -1) {
+		return nullptr;
+	}
+
+	_detach_chunk(chunk_idx);
+	return const_cast<void*>(std::as_const(*this).get_column(chunk_idx, component_id));
+}
+
+const void* Archetype::get_column(size_t chunk_idx, uint32_t component_id) const {
+	const int32_t column_idx = _column_lookup[component_id];
+	if (column_idx == -1) {
+		return nullptr;
+	}
+
+	return _chunks[chunk_idx].get() + _columns[column_idx].offset;
+}
+
+void Archetype::detach() {
+	for (size_t chunk_idx = 0; chunk_idx < _chunks.size(); chunk_idx++) {
+		_detach_chunk(chunk_idx);
+	}
+}
+
+uint32_t Archetype::get_shared_chunk_count() const {
+	return std::count_if(_chunks.begin(), _chunks.end(),
+			[](const std::shared_ptr<uint8_t[]>& chunk) { return chunk.use_count() > 1; });
+}
+
+std::shared_ptr<uint8_t[]> Archetype::_allocate_chunk() const {
+	return std::shared_ptr<uint8_t[]>(new uint8_t[_chunk_bytes]);
+}
+
+void Archetype::_detach_chunk(size_t chunk_idx) {
+	if (_chunks[chunk_idx].use_count() == 1) {
+		return;
+	}
+
+	const uint8_t* src_chunk = _chunks[chunk_idx].get();
+	const uint32_t count = get_chunk_size(chunk_idx);
+
+	std::shared_ptr<uint8_t[]> chunk = _allocate_chunk();
+	std::memcpy(chunk.get(), src_chunk, count * sizeof(Entity));
+
+	// Only the live rows of the chunk need to be copied
+	for (const Column& column : _columns) {
+		uint8_t* dst = chunk.get() + column.offset;
+		const uint8_t* src = src_chunk + column.offset;
+
+		if (!column.info.copy) {
+			std::memcpy(dst, src, count * column.info.size);
+			continue;
+		}
+
+		for (uint32_t slot = 0; slot < count; slot++) {
+			column.info.copy(dst + slot * column.info.size, src + slot * column.info.size);
+		}
+	}
+
+	_chunks[chunk_idx] = std::move(chunk);
+}
+
+bool ViewFilter::matches(uint32_t entity_idx, const ComponentMask& mask) const {
+	if ((mask & excluded).any()) {
 		return false;
 	}
 
-	return _entities[get_entity_index(entity)].mask.test(component_id);
+	if (added.none() && changed.none()) {
+		return true;
+	}
+
+	bool result = true;
+	added.for_each([&](uint32_t component_id) {
+		result = result && (*ticks)[component_id][entity_idx].added > since;
+	});
+	changed.for_each([&](uint32_t component_id) {
+		result = result && (*ticks)[component_id][entity_idx].changed > since;
+	});
+
+	return result;
+}
+
+Query::Query(const ComponentMask& mask) : _mask(mask) {}
+
+const ComponentMask& Query::get_mask() const { return _mask; }
+
+const std::vector<Entity>& Query::get_entities() const { return _entities; }
+
+bool Query::contains(uint32_t entity_idx) const {
+	return entity_idx < _positions.size() && _positions[entity_idx] != INVALID_INDEX;
+}
+
+void Query::_add(Entity entity) {
+	const uint32_t entity_idx = get_entity_index(entity);
+	if (entity_idx >= _positions.size()) {
+		_positions.resize(entity_idx + 1, INVALID_INDEX);
+	}
+
+	_positions[entity_idx] = _entities.size();
+	_entities.push_back(entity);
+}
+
+void Query::_remove(uint32_t entity_idx) {
+	const uint32_t position = _positions[entity_idx];
+
+	// Swap with the last match and pop
+	const Entity last = _entities.back();
+	_entities[position] = last;
+	_positions[get_entity_index(last)] = position;
+
+	_entities.pop_back();
+	_positions[entity_idx] = INVALID_INDEX;
+}
+
+void Query::_relocate(uint32_t entity_idx, Entity entity) {
+	const uint32_t new_idx = get_entity_index(entity);
+	if (new_idx >= _positions.size()) {
+		_positions.resize(new_idx + 1, INVALID_INDEX);
+	}
+
+	const uint32_t position = _positions[entity_idx];
+	_entities[position] = entity;
+	_positions[new_idx] = position;
+	_positions[entity_idx] = INVALID_INDEX;
+}
+
+// Identifies a set of command buffers, a registry takes a new one whenever
+// its buffers are freed so that cached pointers to them are never reused
+static std::atomic<uint64_t> s_command_buffers_generation = 0;
+
+Registry::Registry(StorageMode storage_mode) :
+		_storage_mode(storage_mode), _command_buffers_generation(++s_command_buffers_generation) {}
+
+Registry::~Registry() { clear(); }
+
+StorageMode Registry::get_storage_mode() const { return _storage_mode; }
+
+JobSystem* Registry::get_job_system() { return _job_system; }
+
+EntityCommandBuffer& Registry::get_command_buffer() {
+	// Buffer of the registry last used by the thread
+	static thread_local uint64_t s_cached_generation = 0;
+	static thread_local EntityCommandBuffer* s_cached_buffer = nullptr;
+
+	if (s_cached_generation == _command_buffers_generation) {
+		return *s_cached_buffer;
+	}
+
+	const std::thread::id thread_id = std::this_thread::get_id();
+
+	std::lock_guard<std::mutex> lock(_command_buffers_mutex);
+
+	EntityCommandBuffer* found = nullptr;
+	for (auto& [id, buffer] : _command_buffers) {
+		if (id == thread_id) {
+			found = buffer.get();
+			break;
+		}
+	}
+
+	if (!found) {
+		found = _command_buffers
+						.emplace_back(thread_id, std::make_unique<EntityCommandBuffer>())
+						.second.get();
+	}
+
+	s_cached_generation = _command_buffers_generation;
+	s_cached_buffer = found;
+
+	return *found;
+}
+
+void Registry::flush_commands() {
+	_materialize_reserved();
+
+	std::vector<EntityCommandBuffer*> buffers;
+	for (auto& [id, buffer] : _command_buffers) {
+		if (!buffer->is_empty()) {
+			buffers.push_back(buffer.get());
+		}
+	}
+
+	if (!buffers.empty()) {
+		EntityCommandBuffer::apply(*this, buffers);
+	}
+}
+
+uint32_t Registry::get_change_tick() const { return _change_tick; }
+
+uint32_t Registry::advance_change_tick() { return ++_change_tick; }
+
+uint32_t Registry::get_last_change_tick() const { return _last_change_tick; }
+
+void Registry::set_last_change_tick(uint32_t tick) { _last_change_tick = tick; }
+
+float Registry::get_interpolation_alpha() const { return _interpolation_alpha; }
+
+void Registry::trim_removed(uint32_t tick) {
+	for (auto& removed : _removed_components) {
+		std::erase_if(removed, [tick](const RemovedComponent& rc) { return rc.tick <= tick; });
+	}
+}
+
+void Registry::reserve(uint32_t capacity) {
+	_entities.reserve(capacity);
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		_entity_locations.reserve(capacity);
+	}
+}
+
+void Registry::clear() {
+	{
+		std::lock_guard<std::mutex> lock(_command_buffers_mutex);
+		_command_buffers.clear();
+		_command_buffers_generation = ++s_command_buffers_generation;
+	}
+
+	// Clear all data
+	_groups.clear();
+	_owned_components.reset();
+	_tag_components.reset();
+	_queries.clear();
+	_query_lookup.clear();
+	_component_ticks.clear();
+	_removed_components.clear();
+	_observer_queues[0].clear();
+	_observer_queues[1].clear();
+	_component_pools.clear();
+	_archetypes.clear();
+	_archetype_lookup.clear();
+	_entity_locations.clear();
+	_entities.clear();
+	_free_indices = {};
+	_reserved_count = 0;
+	_entity_counter = 0;
+	_base_version = 0;
+}
+
+MemoryStats Registry::get_memory_stats() const {
+	MemoryStats stats;
+	stats.entity_capacity = _entities.size();
+	stats.free_list_length = _free_indices.size();
+	stats.entity_count = stats.entity_capacity - stats.free_list_length;
+	stats.archetype_count = _archetypes.size();
+
+	size_t entity_bytes = sizeof(Entity) + sizeof(ComponentMask);
+	stats.entity_bytes_reserved =
+			_entities.ids.get_bytes_reserved() + _entities.masks.get_bytes_reserved();
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		entity_bytes += sizeof(EntityLocation);
+		stats.entity_bytes_reserved += _entity_locations.get_bytes_reserved();
+	}
+	stats.entity_bytes_used = stats.entity_count * entity_bytes;
+
+	std::vector<ComponentMemoryStats> components(_component_infos.size());
+	for (uint32_t component_id = 0; component_id < components.size(); component_id++) {
+		components[component_id].component_id = component_id;
+		components[component_id].component_size = _component_infos[component_id].size;
+	}
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		for (const auto& archetype : _archetypes) {
+			const size_t chunk_count = archetype->get_chunk_count();
+			const size_t rows = (size_t)chunk_count * archetype->get_chunk_capacity();
+
+			// Entity ids and column padding of the chunks are attributed
+			// to the entity table
+			size_t column_bytes = 0;
+			archetype->get_mask().for_each([&](uint32_t component_id) {
+				if (!archetype->has_column(component_id)) {
+					return;
+				}
+
+				ComponentMemoryStats& component = components[component_id];
+				component.count += archetype->get_size();
+				component.dense_pages += chunk_count;
+				component.shared_pages += archetype->get_shared_chunk_count();
+				component.bytes_reserved += rows * component.component_size;
+				component.bytes_used += archetype->get_size() * component.component_size;
+
+				column_bytes += rows * component.component_size;
+			});
+
+			stats.entity_bytes_reserved +=
+					chunk_count * archetype->get_chunk_bytes() - column_bytes;
+			stats.entity_bytes_used += archetype->get_size() * sizeof(Entity);
+		}
+	} else {
+		for (uint32_t component_id = 0; component_id < components.size(); component_id++) {
+			if (component_id >= _component_pools.size() || !_component_pools[component_id]) {
+				continue;
+			}
+
+			components[component_id] = _component_pools[component_id]->get_memory_stats();
+			components[component_id].component_id = component_id;
+		}
+	}
+
+	for (ComponentMemoryStats& component : components) {
+		// Ids of unused types and of tags have no layout registered
+		if (component.component_size == 0) {
+			continue;
+		}
+
+		const uint32_t component_id = component.component_id;
+		if (component_id < _component_ticks.size()) {
+			const PagedArray<ComponentTicks>& ticks = _component_ticks[component_id];
+			component.bytes_reserved += ticks.get_bytes_reserved();
+			component.bytes_used += component.count * sizeof(ComponentTicks);
+			component.shared_pages += ticks.get_shared_page_count();
+		}
+
+		stats.components.push_back(component);
+	}
+
+	return stats;
+}
+
+void Registry::copy_to(Registry& dest) {
+	_materialize_reserved();
+	dest.clear();
+
+	// Copy trivial data
+	dest._storage_mode = _storage_mode;
+	dest._entity_counter = _entity_counter;
+	dest._base_version = _base_version;
+	dest._free_indices = _free_indices;
+	dest._component_infos = _component_infos;
+	dest._change_tick = _change_tick;
+	dest._last_change_tick = _last_change_tick;
+	// Only holds the removals since the last trim_removed
+	dest._removed_components = _removed_components;
+
+	// Entity ids, masks and ticks are paged and shared until written to
+	dest._entities = _entities;
+	dest._component_ticks = _component_ticks;
+
+	// Archetypes share their chunks the same way
+	dest._archetype_lookup = _archetype_lookup;
+	dest._entity_locations = _entity_locations;
+	for (const auto& archetype : _archetypes) {
+		dest._archetypes.push_back(std::make_unique<Archetype>(*archetype));
+	}
+
+	// Pools are shared in their grouped order
+	dest._owned_components = _owned_components;
+	dest._tag_components = _tag_components;
+	for (const auto& group : _groups) {
+		dest._groups.push_back(std::make_unique<GroupData>(*group));
+	}
+
+	// Cached queries are shared as well, a query is only copied once an
+	// entity enters or leaves it
+	dest._query_lookup = _query_lookup;
+	dest._queries = _queries;
+
+	// Prepare destination pools
+	dest._component_pools.resize(_component_pools.size(), nullptr);
+
+	// Iterate all pools and share their pages, they get copied on write
+	for (size_t comid = 0; comid < _component_pools.size(); comid++) {
+		if (_component_pools[comid] == nullptr) {
+			continue; // This component type isn't used
+		}
+
+		const auto old_pool = _component_pools[comid];
+		dest._component_pools[comid] = std::make_unique<ComponentPool>(*old_pool);
+	}
+}
+
+Entity Registry::spawn() {
+	GL_ASSERT(!_structure_locked,
+			"Structural changes of concurrent systems must go through the command buffer");
+
+	_materialize_reserved();
+
+	if (!_free_indices.empty()) {
+		uint32_t new_idx = _free_indices.front();
+		_free_indices.pop_front();
+
+		Entity new_id = create_entity_id(new_idx, get_entity_version(_entities.ids[new_idx]));
+
+		_entities.ids.get_writable(new_idx) = new_id;
+
+		return new_id;
+	}
+
+	_entities.push_back(create_entity_id(_entities.size(), _base_version));
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		_entity_locations.push_back({});
+	}
+
+	return _entities.ids.back();
+}
+
+void Registry::spawn_many(std::span<Entity> entities) {
+	_materialize_reserved();
+
+	reserve_entities(entities);
+	_materialize_reserved();
+}
+
+Entity Registry::reserve_entity() {
+	return _get_reserved_id(_reserved_count.fetch_add(1, std::memory_order_relaxed));
+}
+
+void Registry::reserve_entities(std::span<Entity> entities) {
+	const uint32_t first = _reserved_count.fetch_add(entities.size(), std::memory_order_relaxed);
+	for (uint32_t i = 0; i < entities.size(); i++) {
+		entities[i] = _get_reserved_id(first + i);
+	}
+}
+
+bool Registry::is_valid(Entity entity) const {
+	if (get_entity_index(entity) >= _entities.size()) {
+		return false;
+	}
+
+	return _entities.ids[get_entity_index(entity)] == entity;
+}
+
+void Registry::despawn(Entity entity) {
+	GL_ASSERT(!_structure_locked,
+			"Structural changes of concurrent systems must go through the command buffer");
+
+	_materialize_reserved();
+
+	if (!is_valid(entity)) {
+		return;
+	}
+
+	const uint32_t entity_idx = get_entity_index(entity);
+
+	const ComponentMask old_mask = _entities.masks[entity_idx];
+	old_mask.for_each([&](uint32_t comid) { _record_removed(entity, comid); });
+
+	// Queries and groups are updated while the components still exist
+	_set_mask(entity_idx, ComponentMask());
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		_move_to_archetype(entity_idx, ComponentMask());
+	} else {
+		old_mask.for_each([&](uint32_t comid) {
+			if (comid < _component_pools.size() && _component_pools[comid]) {
+				_component_pools[comid]->remove(entity_idx);
+			}
+		});
+	}
+
+	Entity new_entity_id = create_entity_id(UINT32_MAX, get_entity_version(entity) + 1);
+
+	_entities.ids.get_writable(entity_idx) = new_entity_id;
+
+	_free_indices.push_back(entity_idx);
+}
+
+void Registry::_detach_storage(const ComponentMask& mask) {
+	mask.for_each([&](uint32_t component_id) {
+		if (component_id < _component_pools.size() && _component_pools[component_id]) {
+			_component_pools[component_id]->detach();
+		}
+
+		if (component_id < _component_ticks.size()) {
+			_component_ticks[component_id].detach();
+		}
+	});
+
+	for (const auto& archetype : _archetypes) {
+		if ((archetype->get_mask() & mask).any()) {
+			archetype->detach();
+		}
+	}
+}
+
+void Registry::despawn_many(std::span<const Entity> entities) {
+	GL_ASSERT(!_structure_locked,
+			"Structural changes of concurrent systems must go through the command buffer");
+
+	_materialize_reserved();
+
+	std::vector<std::pair<uint32_t, ComponentMask>> despawned;
+	despawned.reserve(entities.size());
+	ComponentMask removed_components;
+
+	for (Entity entity : entities) {
+		if (!is_valid(entity)) {
+			continue;
+		}
+
+		const uint32_t entity_idx = get_entity_index(entity);
+
+		const ComponentMask old_mask = _entities.masks[entity_idx];
+		old_mask.for_each([&](uint32_t comid) { _record_removed(entity, comid); });
+
+		_set_mask(entity_idx, ComponentMask());
+
+		if (_storage_mode == StorageMode::ARCHETYPE) {
+			_move_to_archetype(entity_idx, ComponentMask());
+		} else {
+			despawned.push_back({ entity_idx, old_mask });
+			removed_components = removed_components | old_mask;
+		}
+
+		// Invalidated right away so that duplicates are skipped
+		_entities.ids.get_writable(entity_idx) =
+				create_entity_id(UINT32_MAX, get_entity_version(entity) + 1);
+		_free_indices.push_back(entity_idx);
+	}
+
+	// Pools are emptied one after the other rather than entity by entity
+	removed_components.for_each([&](uint32_t comid) {
+		if (comid >= _component_pools.size() || !_component_pools[comid]) {
+			return;
+		}
+
+		ComponentPool& pool = *_component_pools[comid];
+		for (const auto& [entity_idx, old_mask] : despawned) {
+			if (old_mask.test(comid)) {
+				pool.remove(entity_idx);
+			}
+		}
+	});
+}
+
+uint32_t Registry::observe(uint32_t component_id, ObserverEvent event, ObserverFunc fn) {
+	const uint32_t observer_id = _observer_counter++;
+	_observers.push_back({ observer_id, component_id, event, std::move(fn) });
+	_observed[(size_t)event].set(component_id);
+
+	return observer_id;
+}
+
+void Registry::unobserve(uint32_t observer_id) {
+	for (Observer& observer : _observers) {
+		observer.removed |= observer.id == observer_id;
+	}
+
+	// A callback being dispatched may be the one removed
+	if (_dispatch_depth == 0) {
+		std::erase_if(_observers, [](const Observer& observer) { return observer.removed; });
+	}
+
+	for (ComponentMask& observed : _observed) {
+		observed.reset();
+	}
+	for (const Observer& observer : _observers) {
+		if (!observer.removed) {
+			_observed[(size_t)observer.event].set(observer.component_id);
+		}
+	}
+
+	// Drop events nobody is listening to anymore
+	for (size_t event = 0; event < 2; event++) {
+		std::vector<std::vector<Entity>>& queues = _observer_queues[event];
+		for (uint32_t component_id = 0; component_id < queues.size(); component_id++) {
+			if (!_observed[event].test(component_id)) {
+				queues[component_id].clear();
+			}
+		}
+	}
+}
+
+void Registry::dispatch_observers() {
+	_dispatch_depth++;
+
+	try {
+		_dispatch_observers();
+	} catch (...) {
+		_end_dispatch();
+		throw;
+	}
+
+	_end_dispatch();
+}
+
+void Registry::_end_dispatch() {
+	if (--_dispatch_depth == 0) {
+		std::erase_if(_observers, [](const Observer& observer) { return observer.removed; });
+	}
+}
+
+void Registry::_dispatch_observers() {
+	std::vector<Entity> batch;
+
+	bool pending = true;
+	while (pending) {
+		for (const ObserverEvent event : { ObserverEvent::ADDED, ObserverEvent::REMOVED }) {
+			std::vector<std::vector<Entity>>& queues = _observer_queues[(size_t)event];
+
+			for (uint32_t component_id = 0; component_id < queues.size(); component_id++) {
+				if (queues[component_id].empty()) {
+					continue;
+				}
+
+				batch.clear();
+				std::swap(batch, queues[component_id]);
+
+				std::sort(batch.begin(), batch.end());
+				batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+
+				// Skip entities that lost the component again within the frame
+				if (event == ObserverEvent::ADDED) {
+					std::erase_if(batch,
+							[&](Entity entity) { return !has(entity, component_id); });
+				}
+
+				if (batch.empty()) {
+					continue;
+				}
+
+				// Indexed, callbacks may register observers, which doesn't move
+				// the others, or remove them, which is deferred
+				for (size_t i = 0; i < _observers.size(); i++) {
+					const Observer& observer = _observers[i];
+					if (observer.removed || observer.component_id != component_id ||
+							observer.event != event) {
+						continue;
+					}
+
+					observer.fn(*this, batch);
+				}
+			}
+		}
+
+		// Deliver events raised by the callbacks as well
+		pending = false;
+		for (const auto& queues : _observer_queues) {
+			for (const std::vector<Entity>& queue : queues) {
+				pending |= !queue.empty();
+			}
+		}
+	}
+}
+
+std::vector<EntityRemap> Registry::compact() {
+	flush_commands();
+
+	const uint32_t live_count = _entities.size() - _free_indices.size();
+
+	// Fill the holes from the front with live entities from the back
+	std::vector<EntityRemap> remap;
+	uint32_t src_idx = _entities.size();
+	for (uint32_t dst_idx = 0; dst_idx < live_count; dst_idx++) {
+		if (is_entity_valid(_entities.ids[dst_idx])) {
+			continue;
+		}
+
+		do {
+			src_idx--;
+		} while (!is_entity_valid(_entities.ids[src_idx]));
+
+		// Despawning already bumped the version of the free slot
+		const Entity from = _entities.ids[src_idx];
+		const Entity to = create_entity_id(dst_idx, get_entity_version(_entities.ids[dst_idx]));
+
+		_relocate(src_idx, to);
+		remap.push_back({ from, to });
+	}
+
+	// Ids of the truncated slots must never become valid again
+	for (uint32_t entity_idx = live_count; entity_idx < _entities.size(); entity_idx++) {
+		_base_version =
+				std::max(_base_version, get_entity_version(_entities.ids[entity_idx]) + 1);
+	}
+
+	_entities.resize(live_count);
+	_entities.shrink_to_fit();
+	_free_indices = {};
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		_entity_locations.resize(live_count);
+		_entity_locations.shrink_to_fit();
+	}
+
+	for (PagedArray<ComponentTicks>& ticks : _component_ticks) {
+		if (ticks.size() > live_count) {
+			ticks.resize(live_count);
+			ticks.shrink_to_fit();
+		}
+	}
+
+	for (auto& query : _queries) {
+		if (query->_positions.size() > live_count) {
+			std::vector<uint32_t>& positions = _detach_query(query)._positions;
+			positions.resize(live_count);
+			positions.shrink_to_fit();
+		}
+	}
+
+	for (const auto& pool : _component_pools) {
+		if (pool) {
+			pool->shrink_to_fit();
+		}
+	}
+
+	// Removals of relocated entities are reported under their new id
+	if (!remap.empty()) {
+		std::unordered_map<Entity, Entity> lookup;
+		for (const EntityRemap& entry : remap) {
+			lookup[entry.from] = entry.to;
+		}
+
+		for (std::vector<RemovedComponent>& removed_components : _removed_components) {
+			for (RemovedComponent& removed : removed_components) {
+				const auto it = lookup.find(removed.entity);
+				if (it != lookup.end()) {
+					removed.entity = it->second;
+				}
+			}
+		}
+
+		for (auto& queues : _observer_queues) {
+			for (std::vector<Entity>& queue : queues) {
+				for (Entity& entity : queue) {
+					const auto it = lookup.find(entity);
+					if (it != lookup.end()) {
+						entity = it->second;
+					}
+				}
+			}
+		}
+
+		remap_hierarchy(*this, remap);
+	}
+
+	return remap;
+}
+
+
+bool Registry::assign_id(Entity entity, uint32_t component_id) {
+	if (!is_valid(entity)) {
+		return false;
+	}
+
+	const uint32_t entity_idx = get_entity_index(entity);
+
+	ComponentMask new_mask = _entities.masks[entity_idx];
+	new_mask.set(component_id);
+
+	if (_storage_mode == StorageMode::ARCHETYPE && new_mask != _entities.masks[entity_idx]) {
+		_move_to_archetype(entity_idx, new_mask);
+	}
+
+	_set_mask(entity_idx, new_mask);
+	_set_added(entity_idx, component_id);
+
+	return true;
+}
+
+void* Registry::assign(Entity entity, uint32_t component_id) {
+	if (!is_valid(entity)) {
+		return nullptr;
+	}
+
+	if (_tag_components.test(component_id)) {
+		assign_id(entity, component_id);
+		return nullptr;
+	}
+
+	if (component_id >= _component_infos.size() || _component_infos[component_id].size == 0) {
+		const ComponentType* type = ComponentRegistry::get(component_id);
+		GL_ASSERT(type, "Component type is neither registered nor assigned before");
+
+		if (type->info.size == 0) {
+			_tag_components.set(component_id);
+			assign_id(entity, component_id);
+
+			return nullptr;
+		}
+
+		_register_component(component_id, type->info);
+	}
+
+	const ComponentInfo& info = _component_infos[component_id];
+	const uint32_t entity_idx = get_entity_index(entity);
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		ComponentMask new_mask = _entities.masks[entity_idx];
+		if (!new_mask.test(component_id)) {
+			new_mask.set(component_id);
+			_move_to_archetype(entity_idx, new_mask);
+
+			_set_mask(entity_idx, new_mask);
+		} else {
+			// Replace the existing component
+			info.destroy_at(_archetype_get(entity_idx, component_id));
+		}
+
+		_set_added(entity_idx, component_id);
+
+		void* component = _archetype_get(entity_idx, component_id);
+		info.construct_at(component);
+
+		return component;
+	}
+
+	void* component = _get_or_create_pool(component_id).emplace(entity);
+	info.construct_at(component);
+
+	ComponentMask new_mask = _entities.masks[entity_idx];
+	new_mask.set(component_id);
+	_set_mask(entity_idx, new_mask);
+
+	_set_added(entity_idx, component_id);
+
+	return component;
+}
+
+bool Registry::remove(Entity entity, uint32_t component_id) {
+	if (!is_valid(entity)) {
+		return false;
+	}
+
+	const uint32_t entity_idx = get_entity_index(entity);
+
+	if (_entities.masks[entity_idx].test(component_id)) {
+		ComponentMask new_mask = _entities.masks[entity_idx];
+		new_mask.reset(component_id);
+
+		_record_removed(entity, component_id);
+
+		// Queries and groups are updated while the component still exists
+		_set_mask(entity_idx, new_mask);
+
+		if (_storage_mode == StorageMode::ARCHETYPE) {
+			_move_to_archetype(entity_idx, new_mask);
+		} else if (component_id < _component_pools.size() && _component_pools[component_id]) {
+			_component_pools[component_id]->remove(entity_idx);
+		}
+	}
+
+	return true;
+}
+
+bool Registry::has(Entity entity, uint32_t component_id) const {
+	if (!is_valid(entity)) {
+		return false;
+	}
+
+	return _entities.masks[get_entity_index(entity)].test(component_id);
+}
+
+void* Registry::get(Entity entity, uint32_t component_id) {
+	if (!has(entity, component_id) || _tag_components.test(component_id)) {
+		return nullptr;
+	}
+
+	const uint32_t entity_idx = get_entity_index(entity);
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		return _archetype_get(entity_idx, component_id);
+	}
+
+	return _component_pools[component_id]->get(entity_idx);
+}
+
+const void* Registry::get(Entity entity, uint32_t component_id) const {
+	if (!has(entity, component_id) || _tag_components.test(component_id)) {
+		return nullptr;
+	}
+
+	const uint32_t entity_idx = get_entity_index(entity);
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		return _archetype_get(entity_idx, component_id);
+	}
+
+	const ComponentPool& pool = *_component_pools[component_id];
+	return pool.get(entity_idx);
+}
+
+const std::vector<Entity>& Registry::query(const ComponentMask& mask) {
+	GL_ASSERT(mask.any(), "query requires at least one component");
+	return _get_or_create_query(mask).get_entities();
+}
+
+void Registry::mark_changed(Entity entity, uint32_t component_id) {
+	if (!has(entity, component_id)) {
+		return;
+	}
+
+	_component_ticks[component_id].get_writable(get_entity_index(entity)).changed = _change_tick;
+}
+
+ViewCandidates Registry::_get_candidates(const ComponentMask& mask) {
+	static const std::vector<Entity> s_empty;
+
+	ViewCandidates candidates;
+
+	mask.for_each([&](uint32_t component_id) {
+		if (_tag_components.test(component_id)) {
+			return; // Tags have no pool to iterate
+		}
+
+		if (component_id >= _component_pools.size() || !_component_pools[component_id]) {
+			// No entity owns the component, nothing to iterate
+			candidates = &s_empty;
+			return;
+		}
+
+		const ComponentPool* pool = _component_pools[component_id].get();
+		if (!candidates || pool->get_count() < candidates.size()) {
+			candidates = pool;
+		}
+	});
+
+	return candidates;
+}
+
+Query& Registry::_detach_query(std::shared_ptr<Query>& query) {
+	if (query.use_count() > 1) {
+		query = std::make_shared<Query>(*query);
+	}
+	return *query;
+}
+
+Query& Registry::_get_or_create_query(const ComponentMask& mask) {
+	std::lock_guard<std::mutex> lock(_cache_mutex);
+
+	const auto it = _query_lookup.find(mask);
+	if (it != _query_lookup.end()) {
+		return *_queries[it->second];
+	}
+
+	_query_lookup[mask] = _queries.size();
+	_queries.push_back(std::make_shared<Query>(mask));
+
+	// Populate from the current entities, later changes are tracked by _set_mask
+	Query& query = *_queries.back();
+	const size_t count = _entities.size();
+	MaskScan scan;
+	for (size_t idx = scan.next(_entities.masks, count, mask); idx < count;
+			idx = scan.next(_entities.masks, count, mask)) {
+		query._add(_entities.ids[idx]);
+	}
+
+	return query;
+}
+
+void Registry::_set_mask(uint32_t entity_idx, const ComponentMask& new_mask) {
+	GL_ASSERT(!_structure_locked,
+			"Structural changes of concurrent systems must go through the command buffer");
+
+	const ComponentMask mask = _entities.masks[entity_idx];
+
+	// Groups are updated while every owned component exists
+	for (const auto& group : _groups) {
+		const bool matched = mask.contains(group->mask);
+		const bool matches = new_mask.contains(group->mask);
+
+		if (matches && !matched) {
+			_group_add(*group, entity_idx);
+		} else if (matched && !matches) {
+			_group_remove(*group, entity_idx);
+		}
+	}
+
+	for (auto& query : _queries) {
+		const bool matched = mask.contains(query->get_mask());
+		const bool matches = new_mask.contains(query->get_mask());
+
+		if (matches && !matched) {
+			_detach_query(query)._add(_entities.ids[entity_idx]);
+		} else if (matched && !matches) {
+			_detach_query(query)._remove(entity_idx);
+		}
+	}
+
+	_entities.masks.get_writable(entity_idx) = new_mask;
+}
+
+void Registry::_set_added(uint32_t entity_idx, uint32_t component_id) {
+	if (_component_ticks.size() <= component_id) {
+		_component_ticks.resize(component_id + 1);
+	}
+
+	PagedArray<ComponentTicks>& ticks = _component_ticks[component_id];
+	if (ticks.size() <= entity_idx) {
+		ticks.resize(entity_idx + 1);
+	}
+
+	ticks.get_writable(entity_idx) = { _change_tick, _change_tick };
+
+	if (_observed[(size_t)ObserverEvent::ADDED].test(component_id)) {
+		_queue_observed(ObserverEvent::ADDED, _entities.ids[entity_idx], component_id);
+	}
+}
+
+Entity Registry::_get_reserved_id(uint32_t n) const {
+	// Free slots already carry the bumped version
+	if (n < _free_indices.size()) {
+		const uint32_t entity_idx = _free_indices[n];
+		return create_entity_id(entity_idx, get_entity_version(_entities.ids[entity_idx]));
+	}
+
+	return create_entity_id(_entities.size() + (n - _free_indices.size()), _base_version);
+}
+
+void Registry::_materialize_reserved() {
+	if (_reserved_count.load(std::memory_order_relaxed) == 0) {
+		return;
+	}
+
+	const uint32_t reserved = _reserved_count.exchange(0, std::memory_order_relaxed);
+	const uint32_t recycled = std::min<size_t>(reserved, _free_indices.size());
+
+	for (uint32_t i = 0; i < recycled; i++) {
+		const uint32_t entity_idx = _free_indices.front();
+		_free_indices.pop_front();
+
+		_entities.ids.get_writable(entity_idx) =
+				create_entity_id(entity_idx, get_entity_version(_entities.ids[entity_idx]));
+	}
+
+	const size_t first_idx = _entities.size();
+	const size_t created = reserved - recycled;
+
+	_entities.resize(first_idx + created);
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		_entity_locations.resize(first_idx + created);
+	}
+
+	for (size_t i = 0; i < created; i++) {
+		_entities.ids.get_writable(first_idx + i) = create_entity_id(first_idx + i, _base_version);
+	}
+}
+
+void Registry::_sort_queries(uint32_t component_id) {
+	// Position of the entity inside of the storage of the component
+	const auto get_key = [&](Entity entity) -> uint64_t {
+		const uint32_t entity_idx = get_entity_index(entity);
+		if (_storage_mode == StorageMode::ARCHETYPE) {
+			const EntityLocation& location = _entity_locations[entity_idx];
+			return ((uint64_t)location.archetype << 32) | location.row;
+		}
+
+		return _component_pools[component_id]->get_dense_index(entity_idx);
+	};
+
+	for (auto& query : _queries) {
+		if (!query->get_mask().test(component_id)) {
+			continue;
+		}
+
+		Query& sorted = _detach_query(query);
+		std::vector<Entity>& entities = sorted._entities;
+		std::sort(entities.begin(), entities.end(),
+				[&](Entity lhs, Entity rhs) { return get_key(lhs) < get_key(rhs); });
+
+		for (uint32_t position = 0; position < entities.size(); position++) {
+			sorted._positions[get_entity_index(entities[position])] = position;
+		}
+	}
+}
+
+void Registry::_relocate(uint32_t entity_idx, Entity entity) {
+	const uint32_t new_idx = get_entity_index(entity);
+	const ComponentMask mask = _entities.masks[entity_idx];
+
+	mask.for_each([&](uint32_t component_id) {
+		// Reported as changed, caches keyed by entity index (e.g. draw
+		// caches) hold the data of the previous owner of the index
+		if (component_id < _component_ticks.size() &&
+				entity_idx < _component_ticks[component_id].size()) {
+			PagedArray<ComponentTicks>& ticks = _component_ticks[component_id];
+			ComponentTicks moved = ticks[entity_idx];
+			moved.changed = _change_tick;
+			ticks.get_writable(new_idx) = moved;
+		}
+
+		if (_storage_mode == StorageMode::POOLED && component_id < _component_pools.size() &&
+				_component_pools[component_id]) {
+			_component_pools[component_id]->relocate(entity_idx, entity);
+		}
+	});
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		const EntityLocation location = _entity_locations[entity_idx];
+		if (location.archetype != UINT32_MAX) {
+			_archetypes[location.archetype]->set_entity(location.row, entity);
+		}
+
+		_entity_locations.get_writable(new_idx) = location;
+		_entity_locations.get_writable(entity_idx) = {};
+	}
+
+	for (auto& query : _queries) {
+		if (query->contains(entity_idx)) {
+			_detach_query(query)._relocate(entity_idx, entity);
+		}
+	}
+
+	_entities.ids.get_writable(new_idx) = entity;
+	_entities.masks.get_writable(new_idx) = mask;
+	_entities.ids.get_writable(entity_idx) =
+			create_entity_id(UINT32_MAX, get_entity_version(_entities.ids[entity_idx]));
+	_entities.masks.get_writable(entity_idx).reset();
+}
+
+void Registry::_record_removed(Entity entity, uint32_t component_id) {
+	if (_removed_components.size() <= component_id) {
+		_removed_components.resize(component_id + 1);
+	}
+
+	_removed_components[component_id].push_back({ entity, _change_tick });
+
+	if (_observed[(size_t)ObserverEvent::REMOVED].test(component_id)) {
+		_queue_observed(ObserverEvent::REMOVED, entity, component_id);
+	}
+}
+
+void Registry::_queue_observed(ObserverEvent event, Entity entity, uint32_t component_id) {
+	std::vector<std::vector<Entity>>& queues = _observer_queues[(size_t)event];
+	if (queues.size() <= component_id) {
+		queues.resize(component_id + 1);
+	}
+
+	queues[component_id].push_back(entity);
+}
+
+const Registry::GroupData* Registry::_find_group(const ComponentMask& mask) const {
+	for (const auto& group : _groups) {
+		if (group->mask == mask) {
+			return group.get();
+		}
+	}
+
+	return nullptr;
+}
+
+void Registry::_group_add(GroupData& group, uint32_t entity_idx) {
+	group.owned.for_each([&](uint32_t component_id) {
+		ComponentPool& pool = *_component_pools[component_id];
+
+		const uint32_t dense_idx = pool.get_dense_index(entity_idx);
+		GL_ASSERT(dense_idx != ComponentPool::INVALID_INDEX,
+				"Grouped component has no data, use assign instead of assign_id");
+
+		pool.swap(dense_idx, group.size);
+	});
+
+	group.size++;
+}
+
+void Registry::_group_remove(GroupData& group, uint32_t entity_idx) {
+	group.size--;
+
+	group.owned.for_each([&](uint32_t component_id) {
+		ComponentPool& pool = *_component_pools[component_id];
+		pool.swap(pool.get_dense_index(entity_idx), group.size);
+	});
+}
+
+Archetype& Registry::_get_or_create_archetype(const ComponentMask& mask) {
+	const auto it = _archetype_lookup.find(mask);
+	if (it != _archetype_lookup.end()) {
+		return *_archetypes[it->second];
+	}
+
+	_archetype_lookup[mask] = _archetypes.size();
+	_archetypes.push_back(std::make_unique<Archetype>(mask, _component_infos));
+
+	return *_archetypes.back();
+}
+
+void Registry::_move_to_archetype(uint32_t entity_idx, const ComponentMask& new_mask) {
+	EntityLocation& location = _entity_locations.get_writable(entity_idx);
+
+	Archetype* dst = nullptr;
+	EntityLocation new_location = {};
+	if (new_mask.any()) {
+		dst = &_get_or_create_archetype(new_mask);
+		new_location.archetype = _archetype_lookup[new_mask];
+		new_location.row = dst->push(_entities.ids[entity_idx]);
+	}
+
+	if (location.archetype != UINT32_MAX) {
+		Archetype& src = *_archetypes[location.archetype];
+
+		// Carry the shared components over and destroy the rest
+		src.get_mask().for_each([&](uint32_t comid) {
+			void* src_component = src.get(comid, location.row);
+			if (!src_component) {
+				return;
+			}
+
+			const ComponentInfo& info = _component_infos[comid];
+			if (dst && dst->has_column(comid)) {
+				info.move_to(dst->get(comid, new_location.row), src_component);
+			} else {
+				info.destroy_at(src_component);
+			}
+		});
+
+		const Entity moved = src.swap_remove(location.row);
+		if (moved != INVALID_ENTITY_ID) {
+			_entity_locations.get_writable(get_entity_index(moved)).row = location.row;
+		}
+	}
+
+	location = new_location;
+}
+
+void* Registry::_archetype_get(uint32_t entity_idx, uint32_t component_id) {
+	const EntityLocation& location = _entity_locations[entity_idx];
+	if (location.archetype == UINT32_MAX) {
+		return nullptr;
+	}
+
+	return _archetypes[location.archetype]->get(component_id, location.row);
+}
+
+const void* Registry::_archetype_get(uint32_t entity_idx, uint32_t component_id) const {
+	const EntityLocation& location = _entity_locations[entity_idx];
+	if (location.archetype == UINT32_MAX) {
+		return nullptr;
+	}
+
+	const Archetype& archetype = *_archetypes[location.archetype];
+	return archetype.get(component_id, location.row);
+}
+
+void Registry::_register_component(uint32_t component_id, const ComponentInfo& info) {
+	if (_component_infos.size() <= component_id) {
+		_component_infos.resize(component_id + 1);
+	}
+
+	_component_infos[component_id] = info;
+}
+
+ComponentPool& Registry::_get_or_create_pool(uint32_t component_id) {
+	if (_component_pools.size() <= component_id) {
+		_component_pools.resize(component_id + 1, nullptr);
+	}
+
+	if (!_component_pools[component_id]) {
+		_component_pools[component_id] =
+				std::make_shared<ComponentPool>(_component_infos[component_id]);
+	}
+
+	return *_component_pools[component_id];
 }
 
 } //namespace gl
@@ -1,22 +1,56 @@
 #pragma once
 
+#include "core/assert.h"
+#include "core/component_mask.h"
+#include "core/job_system.h"
+#include "core/paged_array.h"
+
 namespace gl {
 
-// TODO: dynamically allocate
-inline constexpr uint32_t MAX_ENTITIES = 1000;
-inline constexpr uint32_t MAX_COMPONENTS = 32;
+class EntityCommandBuffer;
 
 // first 32 bits is index and last 32 bits are version
 typedef uint64_t Entity;
 
-typedef std::bitset<MAX_COMPONENTS> ComponentMask;
+/**
+ * Ids and component masks of the entities by entity index. Masks live in
+ * their own packed array so views can match many of them at once. Both
+ * are paged, snapshots share the pages until they are written to.
+ */
+struct EntityContainer {
+	static_assert(PagedArray<ComponentMask>::PAGE_SIZE % MaskScan::BATCH_SIZE == 0,
+			"Mask batches must not cross pages");
 
-struct EntityDescriptor {
-	Entity id;
-	ComponentMask mask;
-};
+	PagedArray<Entity> ids;
+	PagedArray<ComponentMask> masks;
+
+	size_t size() const { return ids.size(); }
+
+	void reserve(size_t capacity) {
+		ids.reserve(capacity);
+		masks.reserve(capacity);
+	}
+
+	void resize(size_t size) {
+		ids.resize(size);
+		masks.resize(size);
+	}
 
-typedef std::vector<EntityDescriptor> EntityContainer;
+	void push_back(Entity id) {
+		ids.push_back(id);
+		masks.push_back(ComponentMask());
+	}
+
+	void clear() {
+		ids.clear();
+		masks.clear();
+	}
+
+	void shrink_to_fit() {
+		ids.shrink_to_fit();
+		masks.shrink_to_fit();
+	}
+};
 
 constexpr inline Entity create_entity_id(uint32_t index, uint32_t version) {
 	return ((Entity)index << 32) | version;
@@ -31,48 +65,534 @@ constexpr inline uint32_t get_entity_version(Entity entity) {
 
 constexpr inline bool is_entity_valid(Entity entity) { return (entity >> 32) != UINT32_MAX; }
 
-inline uint32_t s_component_counter = 0;
+/**
+ * Old and new id of an entity relocated by Registry::compact
+ */
+struct EntityRemap {
+	Entity from;
+	Entity to;
+};
+
+enum class ObserverEvent : uint8_t {
+	ADDED,
+	REMOVED,
+};
+
+inline std::atomic<uint32_t> s_component_counter = 0;
 
-// returns different id for different component types
+/**
+ * Hands out the next free component id, also used for component types
+ * registered at runtime
+ */
+inline uint32_t allocate_component_id() {
+	const uint32_t component_id = s_component_counter++;
+	GL_ASSERT(component_id < MAX_COMPONENTS, "Exceeded the maximum number of component types");
+	return component_id;
+}
+
+// returns different id for different component types, const T shares
+// the id of T
 template <class T> inline uint32_t get_component_id() {
-	static uint32_t s_component_id = s_component_counter++;
-	return s_component_id;
+	if constexpr (std::is_const_v<T>) {
+		return get_component_id<std::remove_const_t<T>>();
+	} else {
+		static uint32_t s_component_id = allocate_component_id();
+		return s_component_id;
+	}
 }
 
 inline constexpr Entity INVALID_ENTITY_ID = create_entity_id(UINT32_MAX, 0);
 
 /**
- * Paged component pool for blazingly fast lookups
+ * Memory layout used by the registry to store components
+ */
+enum class StorageMode {
+	// One paged pool per component type, indexed by entity index
+	POOLED,
+	// Entities with the same component mask share fixed-size SoA chunks
+	ARCHETYPE,
+};
+
+/**
+ * Ticks at which a component was added to and last changed on an entity
+ */
+struct ComponentTicks {
+	uint32_t added = 0;
+	uint32_t changed = 0;
+};
+
+/**
+ * View filter matching entities whose T was added since the last run of
+ * the current system
+ */
+template <typename T> struct Added {};
+
+/**
+ * View filter matching entities whose T was added or marked as changed
+ * since the last run of the current system
+ */
+template <typename T> struct Changed {};
+
+/**
+ * View filter matching entities that don't own T
+ */
+template <typename T> struct Without {};
+
+/**
+ * Empty component types are tags, they only live in the component mask
+ * and never get a pool or archetype column
+ */
+template <typename T> inline constexpr bool is_tag_component_v = std::is_empty_v<T>;
+
+template <typename T> struct FilterTraits {
+	using Component = T;
+	static constexpr bool ADDED = false;
+	static constexpr bool CHANGED = false;
+	static constexpr bool WITHOUT = false;
+};
+
+template <typename T> struct FilterTraits<Added<T>> : FilterTraits<T> {
+	static constexpr bool ADDED = true;
+};
+
+template <typename T> struct FilterTraits<Changed<T>> : FilterTraits<T> {
+	static constexpr bool CHANGED = true;
+};
+
+template <typename T> struct FilterTraits<Without<T>> : FilterTraits<T> {
+	static constexpr bool WITHOUT = true;
+};
+
+/**
+ * Added/Changed/Without filters of a view, change ticks are resolved
+ * against the registry
+ */
+struct ViewFilter {
+	const std::vector<PagedArray<ComponentTicks>>* ticks = nullptr;
+	uint32_t since = 0;
+	ComponentMask added;
+	ComponentMask changed;
+	ComponentMask excluded;
+
+	bool matches(uint32_t entity_idx, const ComponentMask& mask) const;
+};
+
+/**
+ * Type-erased layout and lifecycle information of a component type
+ */
+struct ComponentInfo {
+	typedef void (*ConstructFunc)(void* ptr);
+	typedef void (*DestroyFunc)(void* ptr);
+	// Move-constructs dst from src and destroys src
+	typedef void (*MoveFunc)(void* dst, void* src);
+	typedef void (*CopyFunc)(void* dst, const void* src);
+
+	size_t size = 0;
+	size_t alignment = 0;
+
+	// Default constructs in place, components only known at runtime
+	// leave it null and get zero initialized instead
+	ConstructFunc construct = nullptr;
+
+	// Lifecycle hooks, trivially copyable components leave these
+	// null and get relocated/copied with memcpy instead
+	DestroyFunc destroy = nullptr;
+	MoveFunc move = nullptr;
+	CopyFunc copy = nullptr;
+
+	template <typename T> static ComponentInfo create();
+
+	void construct_at(void* ptr) const;
+
+	void destroy_at(void* ptr) const;
+
+	void move_to(void* dst, void* src) const;
+
+	void copy_to(void* dst, const void* src) const;
+
+	/**
+	 * Exchanges two components through a scratch slot of the calling
+	 * thread, sized and aligned for the component
+	 */
+	void swap(void* lhs, void* rhs) const;
+};
+
+/**
+ * Memory held by the storage of a single component type. Pages shared
+ * copy-on-write with a snapshot are reported by both registries.
+ */
+struct ComponentMemoryStats {
+	uint32_t component_id = 0;
+	size_t component_size = 0;
+	// Number of components stored
+	uint32_t count = 0;
+
+	// Bytes allocated for the type, including bookkeeping
+	size_t bytes_reserved = 0;
+	// Bytes of the reserved ones holding live components
+	size_t bytes_used = 0;
+
+	// Dense pages, or chunks holding the type in archetype mode
+	uint32_t dense_pages = 0;
+	uint32_t sparse_pages = 0;
+	// Sparse, component, entity and tick pages or chunks still shared
+	// with a snapshot
+	uint32_t shared_pages = 0;
+
+	/**
+	 * Share of the reserved bytes not holding live components
+	 */
+	float get_fragmentation() const;
+};
+
+/**
+ * Memory usage of a registry, see Registry::get_memory_stats
+ */
+struct MemoryStats {
+	std::vector<ComponentMemoryStats> components;
+
+	// Live entities and entity slots ever created
+	uint32_t entity_count = 0;
+	uint32_t entity_capacity = 0;
+	// Despawned entity indices waiting to be reused
+	uint32_t free_list_length = 0;
+
+	// Entity ids, masks and locations
+	size_t entity_bytes_reserved = 0;
+	size_t entity_bytes_used = 0;
+
+	uint32_t archetype_count = 0;
+
+	size_t get_bytes_reserved() const;
+
+	size_t get_bytes_used() const;
+
+	float get_fragmentation() const;
+};
+
+/**
+ * Sparse-set component pool. Components are tightly packed into dense
+ * pages alongside the entities owning them, while a paged sparse index maps
+ * entity indices into the dense storage for blazingly fast lookups. Dense
+ * storage grows page by page so component pointers stay valid.
+ *
+ * Copying a pool shares its pages, a page is only duplicated once either
+ * side writes to it (copy-on-write), so snapshots cost O(pages touched).
  */
 class ComponentPool {
 public:
-	typedef std::function<void()> DeletorFunc;
-
 	static constexpr size_t PAGE_SIZE = 1024;
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
 
-	ComponentPool(size_t element_size);
+	ComponentPool(const ComponentInfo& info);
 	~ComponentPool();
 
 	ComponentPool(const ComponentPool& other);
 
 	size_t get_size() const;
 
+	/**
+	 * Number of components stored in the pool
+	 */
+	uint32_t get_count() const;
+
+	bool contains(uint32_t idx) const;
+
+	/**
+	 * Mutable access to the component, copies its page if it is shared
+	 * with a snapshot
+	 */
 	void* get(size_t idx);
 
-	template <std::default_initializable T> T* add(uint32_t idx);
+	/**
+	 * Read only access to the component, pages shared with a snapshot
+	 * stay shared
+	 */
+	const void* get(size_t idx) const;
+
+	template <typename T, typename... TArgs> T* add(Entity entity, TArgs&&... args);
+
+	/**
+	 * Uninitialized slot for the component of the entity, an existing
+	 * component is destroyed first. The caller constructs it in place.
+	 */
+	void* emplace(Entity entity);
+
+	/**
+	 * Preallocates dense storage for at least capacity components
+	 */
+	void reserve(uint32_t capacity);
+
+	/**
+	 * Removes the component of the entity index by moving the last
+	 * component into its place.
+	 */
+	void remove(uint32_t idx);
+
+	/**
+	 * Position of the entity index in dense order, INVALID_INDEX if it
+	 * has no component in this pool
+	 */
+	uint32_t get_dense_index(uint32_t idx) const;
+
+	/**
+	 * Moves the component of the entity index over to the given entity,
+	 * keeping its dense position
+	 */
+	void relocate(uint32_t idx, Entity entity);
+
+	/**
+	 * Releases sparse pages without entries and unused dense storage
+	 */
+	void shrink_to_fit();
+
+	/**
+	 * Exchanges two components and their entities in dense order
+	 */
+	void swap(uint32_t lhs_dense_idx, uint32_t rhs_dense_idx);
+
+	/**
+	 * Start of the dense page holding components
+	 * [page_idx * PAGE_SIZE, (page_idx + 1) * PAGE_SIZE)
+	 */
+	void* get_page(size_t page_idx);
+
+	const void* get_page(size_t page_idx) const;
+
+	/**
+	 * Takes private ownership of every page shared with a snapshot, so
+	 * that concurrent writers don't race on copying the same page
+	 */
+	void detach();
+
+	/**
+	 * Entity owning the component at the dense position
+	 */
+	Entity get_entity(uint32_t dense_idx) const {
+		return _entity_pages[dense_idx / PAGE_SIZE][dense_idx % PAGE_SIZE];
+	}
+
+	/**
+	 * Entities owning the components of the dense page, see get_page
+	 */
+	const Entity* get_entity_page(size_t page_idx) const;
+
+	/**
+	 * Page and byte counts of the pool, component_id is left unset
+	 */
+	ComponentMemoryStats get_memory_stats() const;
+
+private:
+	uint32_t& _get_or_create_sparse(uint32_t idx);
+
+	/**
+	 * Entity slot at the dense position for writing, the page is made
+	 * unique
+	 */
+	Entity& _get_dense_entity(uint32_t dense_idx);
+
+	/**
+	 * Pointer to the component slot for writing, the page is made unique
+	 */
+	uint8_t* _get_dense(uint32_t dense_idx);
+
+	void _detach_dense_page(size_t page_idx);
+
+	void _detach_entity_page(size_t page_idx);
+
+	/**
+	 * Uninitialized page aligned for the component type
+	 */
+	std::shared_ptr<uint8_t[]> _allocate_dense_page() const;
+
+	void _push_dense_page();
+
+private:
+	std::vector<std::shared_ptr<uint32_t[]>> _sparse;
+	// Entities are paged alongside the components so that writes after a
+	// snapshot only copy the pages they touch
+	std::vector<std::shared_ptr<Entity[]>> _entity_pages;
+	std::vector<std::shared_ptr<uint8_t[]>> _dense_pages;
+	uint32_t _count = 0;
+	ComponentInfo _info;
+};
+
+/**
+ * Group of entities sharing the exact same component mask. Components are
+ * stored column by column inside fixed-size chunks so that iterating over
+ * an archetype touches contiguous memory.
+ *
+ * Copying an archetype shares its chunks copy-on-write like the pages of
+ * a ComponentPool, mutable accessors copy the chunk they touch if shared.
+ */
+class Archetype {
+public:
+	static constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+	/**
+	 * @param infos component layouts indexed by component id
+	 */
+	Archetype(const ComponentMask& mask, const std::vector<ComponentInfo>& infos);
+	~Archetype();
+
+	Archetype(const Archetype& other);
+
+	const ComponentMask& get_mask() const;
+
+	uint32_t get_size() const;
+
+	uint32_t get_chunk_capacity() const;
+
+	size_t get_chunk_count() const;
+
+	/**
+	 * Bytes allocated for every chunk, entity ids included
+	 */
+	size_t get_chunk_bytes() const;
+
+	/**
+	 * Number of occupied rows inside of the given chunk
+	 */
+	uint32_t get_chunk_size(size_t chunk_idx) const;
+
+	bool has_column(uint32_t component_id) const;
+
+	/**
+	 * Appends a new row with uninitialized component data
+	 *
+	 * @returns row index of the entity
+	 */
+	uint32_t push(Entity entity);
+
+	/**
+	 * Removes the row by moving the last row into its place, components of
+	 * the removed row must already be destroyed or moved out
+	 *
+	 * @returns entity that has been moved into the row or
+	 * INVALID_ENTITY_ID if no relocation happened
+	 */
+	Entity swap_remove(uint32_t row);
+
+	Entity get_entity(uint32_t row) const;
+
+	void set_entity(uint32_t row, Entity entity);
+
+	/**
+	 * Exchanges two rows along with their entities
+	 */
+	void swap(uint32_t lhs_row, uint32_t rhs_row);
+
+	void* get(uint32_t component_id, uint32_t row);
+
+	const void* get(uint32_t component_id, uint32_t row) const;
+
+	const Entity* get_entities(size_t chunk_idx) const;
+
+	void* get_column(size_t chunk_idx, uint32_t component_id);
+
+	const void* get_column(size_t chunk_idx, uint32_t component_id) const;
+
+	/**
+	 * Takes private ownership of every chunk shared with a snapshot, so
+	 * that concurrent writers don't race on copying the same chunk
+	 */
+	void detach();
+
+	uint32_t get_shared_chunk_count() const;
+
+private:
+	std::shared_ptr<uint8_t[]> _allocate_chunk() const;
+
+	void _detach_chunk(size_t chunk_idx);
+
+private:
+	struct Column {
+		uint32_t component_id;
+		ComponentInfo info;
+		size_t offset;
+	};
+
+	ComponentMask _mask;
+	std::vector<Column> _columns;
+	// component id -> column index, -1 if not present
+	std::vector<int32_t> _column_lookup;
+
+	uint32_t _chunk_capacity = 0;
+	size_t _chunk_bytes = 0;
+	uint32_t _size = 0;
+	std::vector<std::shared_ptr<uint8_t[]>> _chunks;
+};
+
+/**
+ * Persistent list of the entities matching a component mask, kept up to
+ * date by the registry on every assign, remove and despawn.
+ */
+class Query {
+public:
+	Query(const ComponentMask& mask);
+
+	const ComponentMask& get_mask() const;
+
+	const std::vector<Entity>& get_entities() const;
+
+	bool contains(uint32_t entity_idx) const;
+
+private:
+	friend class Registry;
+
+	void _add(Entity entity);
+
+	void _remove(uint32_t entity_idx);
+
+	void _relocate(uint32_t entity_idx, Entity entity);
 
 private:
-	std::vector<std::unique_ptr<uint8_t[]>> _pages;
-	size_t _element_size = 0;
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+	ComponentMask _mask;
+	std::vector<Entity> _entities;
+
+	// Entity index to position in _entities
+	std::vector<uint32_t> _positions;
+};
+
+/**
+ * Entities a view tests against its mask, either a list such as the
+ * matches of a query or the paged dense entities of a pool
+ */
+class ViewCandidates {
+public:
+	ViewCandidates() = default;
+	ViewCandidates(const std::vector<Entity>* list) : _list(list) {}
+	ViewCandidates(const ComponentPool* pool) : _pool(pool) {}
+
+	explicit operator bool() const { return _list || _pool; }
+
+	uint32_t size() const { return _list ? _list->size() : _pool->get_count(); }
+
+	Entity operator[](uint32_t idx) const {
+		return _list ? (*_list)[idx] : _pool->get_entity(idx);
+	}
+
+private:
+	const std::vector<Entity>* _list = nullptr;
+	const ComponentPool* _pool = nullptr;
 };
 
 template <typename... TComponents> class SceneView {
 public:
-	SceneView(EntityContainer* entities);
+	/**
+	 * @param candidates entities to test against the view mask, usually
+	 * the dense entities of the smallest participating pool. If empty
+	 * every entity of the container gets tested.
+	 * @param filter ticks used to resolve Added<T> and Changed<T> filters
+	 */
+	SceneView(EntityContainer* entities, ViewCandidates candidates = {}, ViewFilter filter = {});
 
 	class Iterator {
 	public:
-		Iterator(EntityContainer* entities, uint32_t index, ComponentMask mask, bool all);
+		Iterator(EntityContainer* entities, ViewCandidates candidates, uint32_t index,
+				ComponentMask mask, const ViewFilter* filter, bool all);
 
 		Entity operator*() const;
 
@@ -83,12 +603,26 @@ public:
 		Iterator operator++();
 
 	private:
+		friend class SceneView;
+
+		uint32_t _get_count() const;
+
 		bool _is_index_valid();
 
+		/**
+		 * Moves forward to the first matching index at or after the
+		 * current one
+		 */
+		void _seek();
+
 	private:
 		EntityContainer* _entities;
+		ViewCandidates _candidates;
 		uint32_t _index;
+		// Position of the full scan, see _seek
+		MaskScan _scan;
 		ComponentMask _mask;
+		const ViewFilter* _filter;
 		bool _all = false;
 	};
 
@@ -98,19 +632,57 @@ public:
 
 private:
 	EntityContainer* _entities = nullptr;
+	ViewCandidates _candidates;
 	ComponentMask _component_mask;
+	ViewFilter _filter;
 	bool _all = false;
 };
 
+template <typename... TComponents> class Group;
+
 /**
  * Container of entities and components assigned to them.
  */
 class Registry {
 public:
+	// Default number of entities processed by a single par_each job
+	static constexpr uint32_t PAR_CHUNK_SIZE = 256;
+
+	typedef std::function<void(Registry& registry, std::span<const Entity> entities)>
+			ObserverFunc;
+
+	Registry(StorageMode storage_mode = StorageMode::POOLED);
 	virtual ~Registry();
 
+	StorageMode get_storage_mode() const;
+
+	/**
+	 * Preallocates bookkeeping for at least capacity entities
+	 */
+	void reserve(uint32_t capacity);
+
+	/**
+	 * Preallocates storage of the specified component for at least
+	 * capacity entities
+	 */
+	template <typename T> void reserve(uint32_t capacity);
+
 	void clear();
 
+	/**
+	 * Bytes reserved versus used by the entity table and by the storage
+	 * of every component type, tags have no storage and are left out
+	 */
+	MemoryStats get_memory_stats() const;
+
+	/**
+	 * Snapshots the registry into dest. Pool pages, archetype chunks, the
+	 * entity table, change ticks and cached queries are shared
+	 * copy-on-write, so the copy costs O(pages) and only pages written to
+	 * afterwards, by either side, get duplicated. Reads through const
+	 * access (e.g. get<const T>) never duplicate. Component pointers taken
+	 * before the snapshot must be fetched again.
+	 */
 	void copy_to(Registry& dest);
 
 	/**
@@ -118,10 +690,29 @@ public:
 	 */
 	Entity spawn();
 
+	/**
+	 * Creates entities.size() entities at once, writing their ids
+	 * into the given span
+	 */
+	void spawn_many(std::span<Entity> entities);
+
+	/**
+	 * Reserves the id of a new entity without creating it. Lock-free and
+	 * safe to call from any thread, also while other threads iterate. The
+	 * entity becomes valid at the next flush_commands, until then it can be
+	 * referred to by command buffers only.
+	 */
+	Entity reserve_entity();
+
+	/**
+	 * Reserves entities.size() ids at once, see reserve_entity
+	 */
+	void reserve_entities(std::span<Entity> entities);
+
 	/**
 	 * Find out wether the entity is valid or not
 	 */
-	bool is_valid(Entity entity);
+	bool is_valid(Entity entity) const;
 
 	/**
 	 * Removes entity from the scene and increments
@@ -129,18 +720,50 @@ public:
 	 */
 	void despawn(Entity entity);
 
+	/**
+	 * Removes all given entities from the scene, invalid ones are skipped
+	 */
+	void despawn_many(std::span<const Entity> entities);
+
+	/**
+	 * Moves live entities into the lowest free indices so the entity table
+	 * and component pools become dense again, then releases the storage
+	 * left empty. Pending commands are flushed first.
+	 *
+	 * Relocated entities get new ids, every id held outside of the registry
+	 * must be translated through the returned table. Parent and Children
+	 * are translated in place, relocated components are reported as
+	 * changed.
+	 */
+	std::vector<EntityRemap> compact();
+
 	/**
 	 * Sets component mask of the component_id
 	 *
 	 */
 	bool assign_id(Entity entity, uint32_t component_id);
 
+	/**
+	 * Type-erased assign, the component is constructed from the layout
+	 * registered in ComponentRegistry or the one of a previous typed
+	 * assign. Types without storage are assigned as tags and yield null.
+	 */
+	void* assign(Entity entity, uint32_t component_id);
+
 	bool remove(Entity entity, uint32_t component_id);
 
-	bool has(Entity entity, uint32_t component_id);
+	bool has(Entity entity, uint32_t component_id) const;
+
+	/**
+	 * Type-erased get, null for tags and missing components
+	 */
+	void* get(Entity entity, uint32_t component_id);
+
+	const void* get(Entity entity, uint32_t component_id) const;
 
 	/**
-	 * Assigns specified component to the entity
+	 * Assigns specified component to the entity. Empty types are tags,
+	 * only a mask bit is set and a shared dummy instance is returned.
 	 */
 	template <typename T> T* assign(Entity entity);
 
@@ -149,6 +772,13 @@ public:
 	 */
 	template <typename... TComponents> std::tuple<TComponents*...> assign_many(Entity entity);
 
+	/**
+	 * Assigns a copy of value as component T to every given entity,
+	 * reserving storage once. Invalid entities are skipped.
+	 */
+	template <typename T>
+	void assign_many_entities(std::span<const Entity> entities, const T& value = {});
+
 	/**
 	 * Remove specified component from the entity
 	 */
@@ -160,10 +790,19 @@ public:
 	template <typename... TComponents> void remove_many(Entity entity);
 
 	/**
-	 * Get specified component from the entity
+	 * Get specified component from the entity. Writes through the pointer
+	 * aren't tracked, follow them with mark_changed for Changed<T> filters
+	 * and caches built on them to notice. get<const T> reads through the
+	 * const path below.
 	 */
 	template <typename T> T* get(Entity entity);
 
+	/**
+	 * Read only access, unlike the mutable get it doesn't copy pages
+	 * shared with a snapshot and is safe to call from concurrent readers
+	 */
+	template <typename T> const T* get(Entity entity) const;
+
 	/**
 	 * Get specified components from the entity
 	 */
@@ -172,20 +811,426 @@ public:
 	/**
 	 * Find out wether an entity has the specified components
 	 */
-	template <typename... TComponents> bool has(Entity entity);
+	template <typename... TComponents> bool has(Entity entity) const;
+
+	/**
+	 * Number of entities owning the specified component
+	 */
+	template <typename T> uint32_t count();
+
+	/**
+	 * Tick stamped on added and changed components, advanced by World
+	 * after every system
+	 */
+	uint32_t get_change_tick() const;
+
+	uint32_t advance_change_tick();
+
+	/**
+	 * Tick Added<T> and Changed<T> filters compare against, only changes
+	 * made after it are reported
+	 */
+	uint32_t get_last_change_tick() const;
+
+	void set_last_change_tick(uint32_t tick);
+
+	/**
+	 * Share of a fixed step accumulated by World but not simulated yet,
+	 * in [0, 1). It is 1 when no fixed step systems run.
+	 */
+	float get_interpolation_alpha() const;
+
+	/**
+	 * Flags the component as changed so Changed<T> filters pick it up.
+	 * Safe to call from par_each for the entity being processed.
+	 */
+	template <typename T> void mark_changed(Entity entity);
+
+	void mark_changed(Entity entity, uint32_t component_id);
+
+	template <typename T> bool is_added(Entity entity);
+
+	template <typename T> bool is_changed(Entity entity);
+
+	/**
+	 * Entities that lost component T since the last change tick, including
+	 * despawned ones
+	 */
+	template <typename T> std::vector<Entity> get_removed();
+
+	/**
+	 * Forgets removals recorded at or before the given tick
+	 */
+	void trim_removed(uint32_t tick);
+
+	/**
+	 * Registers fn to be called with the entities that gained or lost
+	 * component T. Events are queued and delivered in one batch per
+	 * component by dispatch_observers, which World calls once per frame.
+	 *
+	 * @returns id to pass to unobserve
+	 */
+	template <typename T> uint32_t observe(ObserverEvent event, ObserverFunc fn);
+
+	uint32_t observe(uint32_t component_id, ObserverEvent event, ObserverFunc fn);
+
+	void unobserve(uint32_t observer_id);
+
+	/**
+	 * Delivers queued events. Added batches are sorted, free of duplicates
+	 * and only hold entities still owning the component, removed batches
+	 * hold the ids the entities had, which may be despawned by now. Events
+	 * raised by the callbacks are delivered before returning.
+	 */
+	void dispatch_observers();
 
 	/**
 	 * Get entities with specified components,
 	 * if no component provided it will return all
-	 * of the entities
+	 * of the entities. Added<T> and Changed<T> can be
+	 * used in place of T to only get entities whose
+	 * component was added or changed, Without<T> skips
+	 * entities owning T.
 	 */
 	template <typename... TComponents> SceneView<TComponents...> view();
 
+	/**
+	 * Same as view but iterates a cached query which is maintained
+	 * incrementally, so each iteration only visits matching entities.
+	 * The query is created on first use.
+	 */
+	template <typename... TComponents> SceneView<TComponents...> query();
+
+	/**
+	 * Entities owning every component of mask, from the same cached
+	 * queries as query. For components only known at runtime.
+	 */
+	const std::vector<Entity>& query(const ComponentMask& mask);
+
+	/**
+	 * Invoke `fn(entity, components&...)` for every entity owning the
+	 * specified components. In archetype mode this streams through the
+	 * chunk columns directly instead of looking every component up.
+	 * Components listed as const T are only read, so storage shared with a
+	 * snapshot stays shared.
+	 */
+	template <typename... TComponents, typename Func> void each(Func&& fn);
+
+	/**
+	 * Parallel version of each, splitting the matched entities into
+	 * chunks of chunk_size and running them on the job system of the
+	 * registry. Falls back to serial iteration if no job system is set.
+	 *
+	 * `fn` must only touch the components of the entity it is invoked
+	 * with and must not spawn, despawn, assign or remove.
+	 */
+	template <typename... TComponents, typename Func>
+	void par_each(Func&& fn, uint32_t chunk_size = PAR_CHUNK_SIZE);
+
+	/**
+	 * Gets or creates the group of the specified components, owning the
+	 * ones not owned by another group yet, see Group
+	 */
+	template <typename... TComponents> Group<TComponents...> group();
+
+	/**
+	 * Reorders the storage of T by `compare(const T& lhs, const T& rhs)`,
+	 * e.g. to keep spatial neighbours or draws sharing state together. If T
+	 * is owned by a group, the grouped entities are sorted with the partner
+	 * pools moving in lockstep. In archetype mode the rows of every
+	 * archetype holding T are sorted.
+	 *
+	 * Existing cached queries containing T are reordered to match, so
+	 * each/par_each and groups involving T iterate in the new order.
+	 */
+	template <typename T, typename Compare> void sort(Compare&& compare);
+
+	JobSystem* get_job_system();
+
+	/**
+	 * Command buffer of the calling thread, used to defer structural
+	 * changes while iterating. Safe to call from any thread.
+	 */
+	EntityCommandBuffer& get_command_buffer();
+
+	/**
+	 * Creates the reserved entities, then applies the commands recorded by
+	 * every thread as a single batch. Must not be called while other
+	 * threads are recording.
+	 */
+	void flush_commands();
+
+protected:
+	template <typename... TComponents> friend class Group;
+
+	// Thread pool used by par_each, owned by World
+	JobSystem* _job_system = nullptr;
+
+	// Set by World while systems run concurrently, structural changes
+	// have to go through command buffers then
+	bool _structure_locked = false;
+
+	float _interpolation_alpha = 1.0f;
+
+	/**
+	 * Copies the pool pages, tick pages and archetype chunks of mask shared
+	 * with snapshots up front, threads writing them afterwards would race
+	 * on detaching them
+	 */
+	void _detach_storage(const ComponentMask& mask);
+
 private:
+	/**
+	 * Components a view of TComponents requires, filters resolved
+	 */
+	template <typename... TComponents> static ComponentMask _get_required_mask();
+
+	/**
+	 * Components of TComponents not listed as const
+	 */
+	template <typename... TComponents> static ComponentMask _get_written_mask();
+
+	/**
+	 * Column of T in the chunk, the chunk is only copied from a snapshot
+	 * if T isn't const
+	 */
+	template <typename T> static T* _get_column(Archetype& archetype, size_t chunk_idx);
+
+	/**
+	 * Shared instance handed out for tag components
+	 */
+	template <typename T> static T* _get_tag_instance();
+
+	template <typename T, typename TColumns>
+	static T& _get_column_element(const TColumns& columns, uint32_t row);
+
+	/**
+	 * Dense entities of the smallest pool among the required components,
+	 * null if every one of them is a tag and the masks must be scanned
+	 */
+	ViewCandidates _get_candidates(const ComponentMask& mask);
+
+	/**
+	 * Positions [begin, end) ordered by less(lhs_position, rhs_position)
+	 */
+	template <typename Less>
+	static std::vector<uint32_t> _get_sort_order(uint32_t begin, uint32_t end, Less&& less);
+
+	/**
+	 * Rearranges positions starting at begin through swap(lhs, rhs), so
+	 * that position begin + i receives the element found at order[i]
+	 */
+	template <typename Swap>
+	static void _apply_sort_order(std::vector<uint32_t> order, uint32_t begin, Swap&& swap);
+
+	/**
+	 * Reorders the queries containing the component to follow its storage
+	 */
+	void _sort_queries(uint32_t component_id);
+
+	template <typename T> void _register_component(uint32_t component_id);
+
+	void _register_component(uint32_t component_id, const ComponentInfo& info);
+
+	ComponentPool& _get_or_create_pool(uint32_t component_id);
+
+	// Archetype storage helpers
+
+	Archetype& _get_or_create_archetype(const ComponentMask& mask);
+
+	/**
+	 * Relocates the entity into the archetype matching new_mask, copying
+	 * over the components both archetypes share.
+	 */
+	void _move_to_archetype(uint32_t entity_idx, const ComponentMask& new_mask);
+
+	void* _archetype_get(uint32_t entity_idx, uint32_t component_id);
+
+	const void* _archetype_get(uint32_t entity_idx, uint32_t component_id) const;
+
+	Query& _get_or_create_query(const ComponentMask& mask);
+
+	/**
+	 * Copies the query first if it is shared with a snapshot
+	 */
+	static Query& _detach_query(std::shared_ptr<Query>& query);
+
+	/**
+	 * Updates the component mask of the entity and every query that
+	 * starts or stops matching it
+	 */
+	void _set_mask(uint32_t entity_idx, const ComponentMask& new_mask);
+
+	struct GroupData;
+
+	void _group_add(GroupData& group, uint32_t entity_idx);
+
+	void _group_remove(GroupData& group, uint32_t entity_idx);
+
+	void _set_added(uint32_t entity_idx, uint32_t component_id);
+
+	/**
+	 * Moves the live entity at entity_idx over to the free slot of the
+	 * given id along with its components, ticks and query entries
+	 */
+	void _relocate(uint32_t entity_idx, Entity entity);
+
+	void _record_removed(Entity entity, uint32_t component_id);
+
+	void _queue_observed(ObserverEvent event, Entity entity, uint32_t component_id);
+
+	void _dispatch_observers();
+
+	/**
+	 * Erases removed observers once the outermost dispatch returns
+	 */
+	void _end_dispatch();
+
+	/**
+	 * Id the n-th reservation since the last sync point refers to
+	 */
+	Entity _get_reserved_id(uint32_t n) const;
+
+	/**
+	 * Creates the entities handed out by reserve_entity, must run before
+	 * anything touches the free list or the size of the entity table
+	 */
+	void _materialize_reserved();
+
+private:
+	StorageMode _storage_mode = StorageMode::POOLED;
+
 	uint32_t _entity_counter = 0;
+	// Version of newly created entity slots, raised by compact so that
+	// ids of truncated slots never come back to life
+	uint32_t _base_version = 0;
 	EntityContainer _entities;
-	std::queue<Entity> _free_indices;
+	std::deque<uint32_t> _free_indices;
+	// Reservations since the last sync point, served from the front of
+	// the free list first and from past the end of the table after
+	std::atomic<uint32_t> _reserved_count = 0;
+	std::vector<ComponentInfo> _component_infos;
 	std::vector<std::shared_ptr<ComponentPool>> _component_pools;
+
+	struct EntityLocation {
+		uint32_t archetype = UINT32_MAX;
+		uint32_t row = 0;
+	};
+
+	std::vector<std::unique_ptr<Archetype>> _archetypes;
+	std::unordered_map<ComponentMask, uint32_t> _archetype_lookup;
+	PagedArray<EntityLocation> _entity_locations;
+
+	struct RemovedComponent {
+		Entity entity;
+		uint32_t tick;
+	};
+
+	// Change detection, indexed by component id then entity index
+	uint32_t _change_tick = 1;
+	uint32_t _last_change_tick = 0;
+	std::vector<PagedArray<ComponentTicks>> _component_ticks;
+	std::vector<std::vector<RemovedComponent>> _removed_components;
+
+	struct Observer {
+		uint32_t id;
+		uint32_t component_id;
+		ObserverEvent event;
+		ObserverFunc fn;
+		// Erased once no dispatch is running
+		bool removed = false;
+	};
+
+	// Deque so callbacks keep their address while observers get added
+	std::deque<Observer> _observers;
+	uint32_t _observer_counter = 0;
+	uint32_t _dispatch_depth = 0;
+	// Components with observers per event, other events aren't queued
+	ComponentMask _observed[2];
+	// Queued events, indexed by event then component id
+	std::vector<std::vector<Entity>> _observer_queues[2];
+
+	struct GroupData {
+		ComponentMask mask;
+		// Components whose pools are packed for the group, others are only
+		// required for membership
+		ComponentMask owned;
+		// Number of entities packed at the front of the owned pools
+		uint32_t size = 0;
+	};
+
+	const GroupData* _find_group(const ComponentMask& mask) const;
+
+	std::vector<std::unique_ptr<GroupData>> _groups;
+	ComponentMask _owned_components;
+
+	// Empty component types seen so far, stored in masks only
+	ComponentMask _tag_components;
+
+	// Shared with snapshots until an entity enters or leaves, see _detach_query
+	std::vector<std::shared_ptr<Query>> _queries;
+	std::unordered_map<ComponentMask, uint32_t> _query_lookup;
+
+	// Guards queries and groups created lazily by concurrent systems
+	std::mutex _cache_mutex;
+
+	std::mutex _command_buffers_mutex;
+	std::vector<std::pair<std::thread::id, std::unique_ptr<EntityCommandBuffer>>>
+			_command_buffers;
+	// Key of the buffer pointer each thread caches, see get_command_buffer
+	uint64_t _command_buffers_generation;
+};
+
+/**
+ * Owning group, the pools of the listed components are kept ordered so
+ * that the first get_size() components of each belong to the same entities
+ * in the same order. Iterating a group walks the pools as parallel arrays.
+ *
+ * A component pool can only be owned by one group. In archetype storage
+ * components already live side by side, so groups forward to each/par_each.
+ */
+/**
+ * Entities owning every one of TComponents. The components no other group
+ * owned at creation are owned by the group: their pools keep its entities
+ * packed at the front in the same order, so iterating walks them in
+ * lockstep. The others are looked up per entity, and a group owning none
+ * of its components iterates like Registry::each. Handles stay valid across
+ * Registry::clear and copy_to, falling back to each if the group is gone.
+ */
+template <typename... TComponents> class Group {
+public:
+	explicit Group(Registry* registry);
+
+	uint32_t get_size() const;
+
+	/**
+	 * Invoke `fn(entity, components&...)` for every entity of the group
+	 */
+	template <typename Func> void each(Func&& fn);
+
+	/**
+	 * Parallel version of each, dense pages are split into jobs of
+	 * chunk_size entities. Same restrictions as Registry::par_each apply.
+	 */
+	template <typename Func>
+	void par_each(Func&& fn, uint32_t chunk_size = Registry::PAR_CHUNK_SIZE);
+
+private:
+	/**
+	 * Looked up on every use, null if the registry has no such group
+	 */
+	const Registry::GroupData* _get_data() const;
+
+	/**
+	 * Page of T if the group owns it, null if it is looked up per entity
+	 */
+	template <typename T> T* _get_owned_page(const Registry::GroupData& group, size_t page_idx);
+
+	template <typename Func>
+	void _each_range(const Registry::GroupData& group, Func& fn, uint32_t begin, uint32_t end);
+
+private:
+	Registry* _registry;
 };
 
 } //namespace gl
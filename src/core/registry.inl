@@ -6,24 +6,70 @@
 
 namespace gl {
 
-template <std::default_initializable T> T* ComponentPool::add(uint32_t idx) {
-	GL_ASSERT(sizeof(T) == _element_size, "Given template argument T does not match element_size");
+template <typename T> ComponentInfo ComponentInfo::create() {
+	ComponentInfo info;
+	info.size = sizeof(T);
+	info.alignment = alignof(T);
 
-	const size_t page_idx = idx / PAGE_SIZE;
-	const size_t offset = idx % PAGE_SIZE;
+	if constexpr (std::is_default_constructible_v<T>) {
+		info.construct = [](void* ptr) { new (ptr) T(); };
+	}
 
-	// Ensure we have enough pages
-	if (page_idx >= _pages.size()) {
-		_pages.resize(page_idx + 1);
+	if constexpr (!std::is_trivially_copyable_v<T>) {
+		info.destroy = [](void* ptr) { static_cast<T*>(ptr)->~T(); };
+		info.move = [](void* dst, void* src) {
+			new (dst) T(std::move(*static_cast<T*>(src)));
+			static_cast<T*>(src)->~T();
+		};
+
+		if constexpr (std::is_copy_constructible_v<T>) {
+			info.copy = [](void* dst, const void* src) {
+				new (dst) T(*static_cast<const T*>(src));
+			};
+		} else {
+			info.copy = [](void* dst, const void* src) {
+				GL_ASSERT(false, "Component is not copy constructible");
+			};
+		}
 	}
 
-	// Allocate the page if it doesn't exist
-	if (!_pages[page_idx]) {
-		_pages[page_idx] = std::make_unique<uint8_t[]>(PAGE_SIZE * _element_size);
+	return info;
+}
+
+inline void ComponentInfo::construct_at(void* ptr) const {
+	if (construct) {
+		construct(ptr);
+	} else {
+		std::memset(ptr, 0, size);
 	}
+}
+
+inline void ComponentInfo::destroy_at(void* ptr) const {
+	if (destroy) {
+		destroy(ptr);
+	}
+}
+
+inline void ComponentInfo::move_to(void* dst, void* src) const {
+	if (move) {
+		move(dst, src);
+	} else {
+		std::memcpy(dst, src, size);
+	}
+}
+
+inline void ComponentInfo::copy_to(void* dst, const void* src) const {
+	if (copy) {
+		copy(dst, src);
+	} else {
+		std::memcpy(dst, src, size);
+	}
+}
 
-	void* ptr = _pages[page_idx].get() + (offset * _element_size);
-	return new (ptr) T(); // In-place construction
+template <typename T, typename... TArgs> T* ComponentPool::add(Entity entity, TArgs&&... args) {
+	GL_ASSERT(sizeof(T) == _info.size, "Given template argument T does not match element size");
+
+	return new (emplace(entity)) T(std::forward<TArgs>(args)...); // In-place construction
 }
 
 template <typename T> T* Registry::assign(Entity entity) {
@@ -32,19 +78,42 @@ template <typename T> T* Registry::assign(Entity entity) {
 	}
 
 	const uint32_t component_id = get_component_id<T>();
+	const uint32_t entity_idx = get_entity_index(entity);
+
+	if constexpr (is_tag_component_v<T>) {
+		_tag_components.set(component_id);
+		assign_id(entity, component_id);
 
-	if (_component_pools.size() <= component_id) {
-		_component_pools.resize(component_id + 1, nullptr);
+		return _get_tag_instance<T>();
 	}
 
-	if (!_component_pools[component_id]) {
-		_component_pools[component_id] = std::make_shared<ComponentPool>(sizeof(T));
+	_register_component<T>(component_id);
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		ComponentMask new_mask = _entities.masks[entity_idx];
+		if (!new_mask.test(component_id)) {
+			new_mask.set(component_id);
+			_move_to_archetype(entity_idx, new_mask);
+
+			_set_mask(entity_idx, new_mask);
+		} else {
+			// Replace the existing component
+			std::destroy_at(static_cast<T*>(_archetype_get(entity_idx, component_id)));
+		}
+
+		_set_added(entity_idx, component_id);
+
+		return new (_archetype_get(entity_idx, component_id)) T(); // In-place construction
 	}
 
 	// Bookkeep
-	T* component = _component_pools[component_id]->add<T>(get_entity_index(entity));
+	T* component = _get_or_create_pool(component_id).add<T>(entity);
+
+	ComponentMask new_mask = _entities.masks[entity_idx];
+	new_mask.set(component_id);
+	_set_mask(entity_idx, new_mask);
 
-	_entities[get_entity_index(entity)].mask.set(component_id);
+	_set_added(entity_idx, component_id);
 
 	return component;
 }
@@ -58,6 +127,47 @@ std::tuple<TComponents*...> Registry::assign_many(Entity entity) {
 	return std::make_tuple(assign<TComponents>(entity)...);
 }
 
+template <typename T>
+void Registry::assign_many_entities(std::span<const Entity> entities, const T& value) {
+	if constexpr (is_tag_component_v<T>) {
+		// Tags only set mask bits, they must never get a layout
+		for (Entity entity : entities) {
+			assign<T>(entity);
+		}
+		return;
+	}
+
+	const uint32_t component_id = get_component_id<T>();
+
+	_register_component<T>(component_id);
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		for (Entity entity : entities) {
+			if (T* component = assign<T>(entity)) {
+				*component = value;
+			}
+		}
+		return;
+	}
+
+	ComponentPool& pool = _get_or_create_pool(component_id);
+	pool.reserve(pool.get_count() + entities.size());
+
+	for (Entity entity : entities) {
+		if (!is_valid(entity)) {
+			continue;
+		}
+
+		pool.template add<T>(entity, value);
+
+		ComponentMask new_mask = _entities.masks[get_entity_index(entity)];
+		new_mask.set(component_id);
+		_set_mask(get_entity_index(entity), new_mask);
+
+		_set_added(get_entity_index(entity), component_id);
+	}
+}
+
 template <typename T> bool Registry::remove(Entity entity) {
 	if (!is_valid(entity)) {
 		return false;
@@ -77,21 +187,53 @@ template <typename... TComponents> void Registry::remove_many(Entity entity) {
 }
 
 template <typename T> T* Registry::get(Entity entity) {
+	if constexpr (std::is_const_v<T>) {
+		return std::as_const(*this).template get<std::remove_const_t<T>>(entity);
+	}
+
 	if (!is_valid(entity)) {
 		return nullptr;
 	}
 
 	const uint32_t component_id = get_component_id<T>();
-	if (!_entities[get_entity_index(entity)].mask.test(component_id)) {
+	if (!_entities.masks[get_entity_index(entity)].test(component_id)) {
 		return nullptr;
 	}
 
 	const uint32_t entity_idx = get_entity_index(entity);
 
+	if constexpr (is_tag_component_v<T>) {
+		return _get_tag_instance<T>();
+	}
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		return static_cast<T*>(_archetype_get(entity_idx, component_id));
+	}
+
 	T* component = static_cast<T*>(_component_pools[component_id]->get(entity_idx));
 	return component;
 }
 
+template <typename T> const T* Registry::get(Entity entity) const {
+	if (!has<T>(entity)) {
+		return nullptr;
+	}
+
+	if constexpr (is_tag_component_v<T>) {
+		return _get_tag_instance<T>();
+	}
+
+	const uint32_t component_id = get_component_id<T>();
+	const uint32_t entity_idx = get_entity_index(entity);
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		return static_cast<const T*>(_archetype_get(entity_idx, component_id));
+	}
+
+	const ComponentPool& pool = *_component_pools[component_id];
+	return static_cast<const T*>(pool.get(entity_idx));
+}
+
 template <typename... TComponents> std::tuple<TComponents*...> Registry::get_many(Entity entity) {
 	if (!is_valid(entity)) {
 		return std::make_tuple(static_cast<TComponents*>(nullptr)...);
@@ -100,14 +242,14 @@ template <typename... TComponents> std::tuple<TComponents*...> Registry::get_man
 	return std::make_tuple(get<TComponents>(entity)...);
 }
 
-template <typename... TComponents> bool Registry::has(Entity entity) {
+template <typename... TComponents> bool Registry::has(Entity entity) const {
 	if (!is_valid(entity)) {
 		return false;
 	}
 
 	const uint32_t component_ids[] = { get_component_id<TComponents>()... };
 	for (int i = 0; i < sizeof...(TComponents); i++) {
-		if (!_entities[get_entity_index(entity)].mask.test(component_ids[i])) {
+		if (!_entities.masks[get_entity_index(entity)].test(component_ids[i])) {
 			return false;
 		}
 	}
@@ -115,52 +257,495 @@ template <typename... TComponents> bool Registry::has(Entity entity) {
 	return true;
 }
 
+template <typename T> uint32_t Registry::count() {
+	const uint32_t component_id = get_component_id<T>();
+
+	if constexpr (is_tag_component_v<T>) {
+		ComponentMask mask;
+		mask.set(component_id);
+		return _get_or_create_query(mask).get_entities().size();
+	}
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		uint32_t total = 0;
+		for (const auto& archetype : _archetypes) {
+			if (archetype->get_mask().test(component_id)) {
+				total += archetype->get_size();
+			}
+		}
+		return total;
+	}
+
+	if (component_id >= _component_pools.size() || !_component_pools[component_id]) {
+		return 0;
+	}
+
+	return _component_pools[component_id]->get_count();
+}
+
+template <typename T> void Registry::mark_changed(Entity entity) {
+	mark_changed(entity, get_component_id<T>());
+}
+
+template <typename T> bool Registry::is_added(Entity entity) {
+	if (!has<T>(entity)) {
+		return false;
+	}
+
+	return _component_ticks[get_component_id<T>()][get_entity_index(entity)].added >
+			_last_change_tick;
+}
+
+template <typename T> bool Registry::is_changed(Entity entity) {
+	if (!has<T>(entity)) {
+		return false;
+	}
+
+	return _component_ticks[get_component_id<T>()][get_entity_index(entity)].changed >
+			_last_change_tick;
+}
+
+template <typename T> std::vector<Entity> Registry::get_removed() {
+	const uint32_t component_id = get_component_id<T>();
+	if (component_id >= _removed_components.size()) {
+		return {};
+	}
+
+	std::vector<Entity> entities;
+	for (const RemovedComponent& removed : _removed_components[component_id]) {
+		if (removed.tick > _last_change_tick) {
+			entities.push_back(removed.entity);
+		}
+	}
+
+	return entities;
+}
+
+template <typename T> uint32_t Registry::observe(ObserverEvent event, ObserverFunc fn) {
+	return observe(get_component_id<T>(), event, std::move(fn));
+}
+
 template <typename... TComponents> SceneView<TComponents...> Registry::view() {
-	return SceneView<TComponents...>(&_entities);
+	const ViewFilter filter = { &_component_ticks, _last_change_tick };
+
+	if constexpr (sizeof...(TComponents) == 0) {
+		return SceneView<TComponents...>(&_entities);
+	} else {
+		if (_storage_mode == StorageMode::ARCHETYPE) {
+			return SceneView<TComponents...>(&_entities, {}, filter);
+		}
+
+		// Drive the iteration from the smallest participating pool, views
+		// of tags only scan the masks
+		const ViewCandidates candidates = _get_candidates(_get_required_mask<TComponents...>());
+
+		return SceneView<TComponents...>(&_entities, candidates, filter);
+	}
+}
+
+template <typename... TComponents> SceneView<TComponents...> Registry::query() {
+	static_assert(sizeof...(TComponents) > 0, "query requires at least one component");
+
+	const ComponentMask mask = _get_required_mask<TComponents...>();
+	GL_ASSERT(mask.any(), "query requires at least one component that isn't excluded");
+
+	const ViewFilter filter = { &_component_ticks, _last_change_tick };
+
+	return SceneView<TComponents...>(
+			&_entities, &_get_or_create_query(mask).get_entities(), filter);
+}
+
+template <typename... TComponents, typename Func> void Registry::each(Func&& fn) {
+	static_assert(sizeof...(TComponents) > 0, "each requires at least one component");
+
+	ComponentMask mask;
+	(mask.set(get_component_id<TComponents>()), ...);
+
+	if (_storage_mode != StorageMode::ARCHETYPE) {
+		// The cached query holds exactly the matches, no mask tests needed
+		for (Entity entity : _get_or_create_query(mask).get_entities()) {
+			fn(entity, *get<TComponents>(entity)...);
+		}
+		return;
+	}
+
+	for (const auto& archetype : _archetypes) {
+		if (!archetype->get_mask().contains(mask)) {
+			continue;
+		}
+
+		for (size_t chunk_idx = 0; chunk_idx < archetype->get_chunk_count(); chunk_idx++) {
+			const uint32_t count = archetype->get_chunk_size(chunk_idx);
+			const Entity* entities = archetype->get_entities(chunk_idx);
+
+			// Resolve the columns once per chunk and walk them in lockstep
+			std::tuple<TComponents*...> columns = { _get_column<TComponents>(
+					*archetype, chunk_idx)... };
+
+			for (uint32_t row = 0; row < count; row++) {
+				fn(entities[row], _get_column_element<TComponents>(columns, row)...);
+			}
+		}
+	}
+}
+
+template <typename... TComponents, typename Func>
+void Registry::par_each(Func&& fn, uint32_t chunk_size) {
+	static_assert(sizeof...(TComponents) > 0, "par_each requires at least one component");
+
+	if (!_job_system) {
+		each<TComponents...>(fn);
+		return;
+	}
+
+	ComponentMask mask;
+	(mask.set(get_component_id<TComponents>()), ...);
+
+	// Only what is written gets copied from snapshots, concurrent reads
+	// leave shared storage alone
+	_detach_storage(_get_written_mask<TComponents...>());
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		// Rows are numbered across the matching archetypes so that jobs
+		// cover chunk_size entities however the chunks are filled
+		std::vector<Archetype*> archetypes;
+		std::vector<uint32_t> offsets;
+		uint32_t count = 0;
+		for (const auto& archetype : _archetypes) {
+			if (archetype->get_size() == 0 || !archetype->get_mask().contains(mask)) {
+				continue;
+			}
+
+			archetypes.push_back(archetype.get());
+			offsets.push_back(count);
+			count += archetype->get_size();
+		}
+
+		_job_system->parallel_for(count, chunk_size, [&](uint32_t begin, uint32_t end) {
+			size_t archetype_idx =
+					std::upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin() - 1;
+
+			for (uint32_t i = begin; i < end;) {
+				Archetype& archetype = *archetypes[archetype_idx];
+
+				const uint32_t row = i - offsets[archetype_idx];
+				const size_t chunk_idx = row / archetype.get_chunk_capacity();
+				const uint32_t first = row % archetype.get_chunk_capacity();
+				// Up to the end of the chunk or of the job, whichever comes first
+				const uint32_t last =
+						std::min(archetype.get_chunk_size(chunk_idx), first + end - i);
+
+				const Entity* entities = archetype.get_entities(chunk_idx);
+				std::tuple<TComponents*...> columns = { _get_column<TComponents>(
+						archetype, chunk_idx)... };
+
+				for (uint32_t slot = first; slot < last; slot++) {
+					fn(entities[slot], _get_column_element<TComponents>(columns, slot)...);
+				}
+
+				i += last - first;
+				if (row + last - first == archetype.get_size()) {
+					archetype_idx++;
+				}
+			}
+		});
+
+		return;
+	}
+
+	const std::vector<Entity>& matches = _get_or_create_query(mask).get_entities();
+
+	_job_system->parallel_for(matches.size(), chunk_size, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			const Entity entity = matches[i];
+			fn(entity, *get<TComponents>(entity)...);
+		}
+	});
+}
+
+template <typename... TComponents> Group<TComponents...> Registry::group() {
+	static_assert(sizeof...(TComponents) > 0, "group requires at least one component");
+	static_assert((!is_tag_component_v<TComponents> && ...), "tags can't be owned by a group");
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		return Group<TComponents...>(this);
+	}
+
+	ComponentMask mask;
+	(mask.set(get_component_id<TComponents>()), ...);
+
+	std::lock_guard<std::mutex> lock(_cache_mutex);
+
+	if (_find_group(mask)) {
+		return Group<TComponents...>(this);
+	}
+
+	// Pools can only be packed for a single group, the others look them up
+	const ComponentMask owned = mask & ~_owned_components;
+	if (owned.none()) {
+		return Group<TComponents...>(this);
+	}
+
+	// Packing reorders the pools, which concurrent systems may be reading
+	GL_ASSERT(!_structure_locked, "Groups must be created outside of concurrent stages");
+
+	(_register_component<std::remove_const_t<TComponents>>(get_component_id<TComponents>()), ...);
+	(_get_or_create_pool(get_component_id<TComponents>()), ...);
+
+	_groups.push_back(std::make_unique<GroupData>());
+
+	GroupData& group = *_groups.back();
+	group.mask = mask;
+	group.owned = owned;
+	_owned_components = _owned_components | owned;
+
+	// Pack the entities that already own every component
+	const size_t count = _entities.size();
+	MaskScan scan;
+	for (size_t idx = scan.next(_entities.masks, count, mask); idx < count;
+			idx = scan.next(_entities.masks, count, mask)) {
+		_group_add(group, idx);
+	}
+
+	return Group<TComponents...>(this);
+}
+
+template <typename T, typename Compare> void Registry::sort(Compare&& compare) {
+	static_assert(!is_tag_component_v<T>, "tags have no storage to sort");
+
+	const uint32_t component_id = get_component_id<T>();
+
+	if (_storage_mode == StorageMode::ARCHETYPE) {
+		for (const auto& archetype : _archetypes) {
+			if (!archetype->has_column(component_id)) {
+				continue;
+			}
+
+			const auto get = [&](uint32_t row) -> const T& {
+				return *static_cast<T*>(archetype->get(component_id, row));
+			};
+
+			std::vector<uint32_t> order =
+					_get_sort_order(0, archetype->get_size(), [&](uint32_t lhs, uint32_t rhs) {
+						return compare(get(lhs), get(rhs));
+					});
+
+			_apply_sort_order(std::move(order), 0, [&](uint32_t lhs, uint32_t rhs) {
+				archetype->swap(lhs, rhs);
+				for (uint32_t row : { lhs, rhs }) {
+					const uint32_t entity_idx = get_entity_index(archetype->get_entity(row));
+					_entity_locations.get_writable(entity_idx).row = row;
+				}
+			});
+		}
+
+		_sort_queries(component_id);
+		return;
+	}
+
+	if (component_id >= _component_pools.size() || !_component_pools[component_id]) {
+		return;
+	}
+
+	ComponentPool& pool = *_component_pools[component_id];
+
+	// Pages are detached up front, sorting writes to all of them anyway
+	const auto get = [&](uint32_t dense_idx) -> const T& {
+		uint8_t* page = static_cast<uint8_t*>(pool.get_page(dense_idx / ComponentPool::PAGE_SIZE));
+		return *reinterpret_cast<T*>(page + (dense_idx % ComponentPool::PAGE_SIZE) * sizeof(T));
+	};
+
+	const auto less = [&](uint32_t lhs, uint32_t rhs) { return compare(get(lhs), get(rhs)); };
+
+	// Grouped entities stay packed at the front of every owned pool
+	uint32_t begin = 0;
+	if (_owned_components.test(component_id)) {
+		for (const auto& group : _groups) {
+			if (!group->owned.test(component_id)) {
+				continue;
+			}
+
+			const std::vector<uint32_t> order = _get_sort_order(0, group->size, less);
+			group->owned.for_each([&](uint32_t owned_id) {
+				ComponentPool& owned_pool = *_component_pools[owned_id];
+				_apply_sort_order(order, 0,
+						[&](uint32_t lhs, uint32_t rhs) { owned_pool.swap(lhs, rhs); });
+			});
+
+			begin = group->size;
+			break;
+		}
+	}
+
+	std::vector<uint32_t> order = _get_sort_order(begin, pool.get_count(), less);
+	_apply_sort_order(std::move(order), begin,
+			[&](uint32_t lhs, uint32_t rhs) { pool.swap(lhs, rhs); });
+
+	_sort_queries(component_id);
+}
+
+template <typename Less>
+std::vector<uint32_t> Registry::_get_sort_order(uint32_t begin, uint32_t end, Less&& less) {
+	std::vector<uint32_t> order(end - begin);
+	std::iota(order.begin(), order.end(), begin);
+	std::sort(order.begin(), order.end(), less);
+	return order;
+}
+
+template <typename Swap>
+void Registry::_apply_sort_order(std::vector<uint32_t> order, uint32_t begin, Swap&& swap) {
+	// Walk every cycle of the permutation, each swap settles one position
+	for (uint32_t i = 0; i < order.size(); i++) {
+		uint32_t current = i;
+		while (order[current] != begin + i) {
+			const uint32_t next = order[current] - begin;
+			swap(begin + current, begin + next);
+			order[current] = begin + current;
+			current = next;
+		}
+		order[current] = begin + current;
+	}
+}
+
+template <typename T> void Registry::reserve(uint32_t capacity) {
+	if constexpr (is_tag_component_v<T>) {
+		return; // Tags don't have storage
+	}
+
+	const uint32_t component_id = get_component_id<T>();
+
+	_register_component<T>(component_id);
+
+	if (_storage_mode == StorageMode::POOLED) {
+		_get_or_create_pool(component_id).reserve(capacity);
+	}
+}
+
+template <typename T> void Registry::_register_component(uint32_t component_id) {
+	if (component_id >= _component_infos.size() || _component_infos[component_id].size == 0) {
+		_register_component(component_id, ComponentInfo::create<T>());
+	}
+}
+
+template <typename... TComponents> ComponentMask Registry::_get_required_mask() {
+	ComponentMask mask;
+	(
+			[&] {
+				if constexpr (!FilterTraits<TComponents>::WITHOUT) {
+					mask.set(get_component_id<typename FilterTraits<TComponents>::Component>());
+				}
+			}(),
+			...);
+
+	return mask;
+}
+
+template <typename... TComponents> ComponentMask Registry::_get_written_mask() {
+	ComponentMask mask;
+	(
+			[&] {
+				if constexpr (!std::is_const_v<TComponents>) {
+					mask.set(get_component_id<TComponents>());
+				}
+			}(),
+			...);
+
+	return mask;
+}
+
+template <typename T> T* Registry::_get_column(Archetype& archetype, size_t chunk_idx) {
+	if constexpr (std::is_const_v<T>) {
+		const Archetype& shared = archetype;
+		return static_cast<T*>(shared.get_column(chunk_idx, get_component_id<T>()));
+	} else {
+		return static_cast<T*>(archetype.get_column(chunk_idx, get_component_id<T>()));
+	}
+}
+
+template <typename T> T* Registry::_get_tag_instance() {
+	static T s_tag;
+	return &s_tag;
+}
+
+template <typename T, typename TColumns>
+T& Registry::_get_column_element(const TColumns& columns, uint32_t row) {
+	if constexpr (is_tag_component_v<T>) {
+		// Tags have no column
+		return *_get_tag_instance<std::remove_const_t<T>>();
+	} else {
+		return std::get<T*>(columns)[row];
+	}
 }
 
 template <typename... TComponents>
-SceneView<TComponents...>::SceneView(EntityContainer* entities) : _entities(entities) {
+SceneView<TComponents...>::SceneView(
+		EntityContainer* entities, ViewCandidates candidates, ViewFilter filter) :
+		_entities(entities), _candidates(candidates), _filter(filter) {
 	if constexpr (sizeof...(TComponents) == 0) {
 		_all = true;
 	} else {
 		// unpack the parameter list and set the component mask accordingly
-		const uint32_t component_ids[] = { get_component_id<TComponents>()... };
+		const uint32_t component_ids[] = {
+			get_component_id<typename FilterTraits<TComponents>::Component>()...
+		};
+		const bool added[] = { FilterTraits<TComponents>::ADDED... };
+		const bool changed[] = { FilterTraits<TComponents>::CHANGED... };
+		const bool without[] = { FilterTraits<TComponents>::WITHOUT... };
+
 		for (int i = 0; i < sizeof...(TComponents); i++) {
+			if (without[i]) {
+				_filter.excluded.set(component_ids[i]);
+				continue;
+			}
+
 			_component_mask.set(component_ids[i]);
+
+			if (added[i]) {
+				_filter.added.set(component_ids[i]);
+			}
+			if (changed[i]) {
+				_filter.changed.set(component_ids[i]);
+			}
 		}
+
+		// Only exclusions, every live entity is a candidate
+		_all = _component_mask.none();
 	}
 }
 
 template <typename... TComponents>
 const typename SceneView<TComponents...>::Iterator SceneView<TComponents...>::begin() const {
-	uint32_t first_index = 0;
-	while (first_index < _entities->size() &&
-			(_component_mask != (_component_mask & _entities->at(first_index).mask) ||
-					!is_entity_valid(_entities->at(first_index).id))) {
-		first_index++;
-	}
+	Iterator it(_entities, _candidates, 0, _component_mask, &_filter, _all);
+	it._seek();
 
-	return Iterator(_entities, first_index, _component_mask, _all);
+	return it;
 }
 
 template <typename... TComponents>
 const typename SceneView<TComponents...>::Iterator SceneView<TComponents...>::end() const {
-	return Iterator(_entities, _entities->size(), _component_mask, _all);
+	const uint32_t count = _candidates ? _candidates.size() : _entities->size();
+	return Iterator(_entities, _candidates, count, _component_mask, &_filter, _all);
 }
 
 template <typename... TComponents>
-SceneView<TComponents...>::Iterator::Iterator(
-		EntityContainer* entities, uint32_t index, ComponentMask mask, bool all) :
-		_entities(entities), _index(index), _mask(mask), _all(all) {}
+SceneView<TComponents...>::Iterator::Iterator(EntityContainer* entities,
+		ViewCandidates candidates, uint32_t index, ComponentMask mask, const ViewFilter* filter,
+		bool all) :
+		_entities(entities),
+		_candidates(candidates),
+		_index(index),
+		_scan(index),
+		_mask(mask),
+		_filter(filter),
+		_all(all) {}
 
 template <typename... TComponents> Entity SceneView<TComponents...>::Iterator::operator*() const {
-	return _entities->at(_index).id;
+	return _candidates ? _candidates[_index] : _entities->ids[_index];
 }
 
 template <typename... TComponents>
 bool SceneView<TComponents...>::Iterator::operator==(const Iterator& other) const {
-	return _index == other._index || _index == _entities->size();
+	return _index == other._index || _index >= _get_count();
 }
 
 template <typename... TComponents>
@@ -170,19 +755,162 @@ bool SceneView<TComponents...>::Iterator::operator!=(const Iterator& other) cons
 
 template <typename... TComponents>
 typename SceneView<TComponents...>::Iterator SceneView<TComponents...>::Iterator::operator++() {
-	do {
-		_index++;
-	} while (_index < _entities->size() && !_is_index_valid());
+	_index++;
+	_seek();
 
 	return *this;
 }
 
+template <typename... TComponents>
+uint32_t SceneView<TComponents...>::Iterator::_get_count() const {
+	return _candidates ? _candidates.size() : _entities->size();
+}
+
 template <typename... TComponents> bool SceneView<TComponents...>::Iterator::_is_index_valid() {
+	if (_candidates) {
+		// Candidates are always alive, they only need to own the rest of the components
+		const uint32_t entity_idx = get_entity_index(_candidates[_index]);
+		const ComponentMask& mask = _entities->masks[entity_idx];
+		return mask.contains(_mask) && _filter->matches(entity_idx, mask);
+	}
+
 	return
 			// It's a valid entity ID
-			is_entity_valid(_entities->at(_index).id) &&
+			is_entity_valid(_entities->ids[_index]) &&
 			// It has the correct component mask
-			(_all || _mask == (_mask & _entities->at(_index).mask));
+			(_all || _entities->masks[_index].contains(_mask)) &&
+			// It passes the Added/Changed/Without filters
+			_filter->matches(_index, _entities->masks[_index]);
+}
+
+template <typename... TComponents> void SceneView<TComponents...>::Iterator::_seek() {
+	const uint32_t count = _get_count();
+
+	if (_candidates || _all) {
+		while (_index < count && !_is_index_valid()) {
+			_index++;
+		}
+		return;
+	}
+
+	// Full scan, skip over non-matching entities in bulk. Despawned entities
+	// have an empty mask so they never match.
+	while (true) {
+		_index = _scan.next(_entities->masks, count, _mask);
+		if (_index >= count) {
+			return;
+		}
+
+		// The batch may have been tested before the loop body changed the mask
+		const ComponentMask& mask = _entities->masks[_index];
+		if (mask.contains(_mask) && _filter->matches(_index, mask)) {
+			return;
+		}
+	}
+}
+
+template <typename... TComponents>
+Group<TComponents...>::Group(Registry* registry) : _registry(registry) {}
+
+template <typename... TComponents> uint32_t Group<TComponents...>::get_size() const {
+	const Registry::GroupData* group = _get_data();
+	if (!group) {
+		uint32_t count = 0;
+		_registry->template each<TComponents...>([&](Entity, TComponents&...) { count++; });
+		return count;
+	}
+
+	return group->size;
+}
+
+template <typename... TComponents>
+template <typename Func>
+void Group<TComponents...>::each(Func&& fn) {
+	const Registry::GroupData* group = _get_data();
+	if (!group) {
+		_registry->template each<TComponents...>(fn);
+		return;
+	}
+
+	_each_range(*group, fn, 0, group->size);
+}
+
+template <typename... TComponents>
+template <typename Func>
+void Group<TComponents...>::par_each(Func&& fn, uint32_t chunk_size) {
+	const Registry::GroupData* group = _get_data();
+	if (!group) {
+		_registry->template par_each<TComponents...>(fn, chunk_size);
+		return;
+	}
+
+	JobSystem* jobs = _registry->get_job_system();
+	if (!jobs) {
+		_each_range(*group, fn, 0, group->size);
+		return;
+	}
+
+	_registry->_detach_storage(_registry->template _get_written_mask<TComponents...>());
+
+	jobs->parallel_for(group->size, chunk_size,
+			[&](uint32_t begin, uint32_t end) { _each_range(*group, fn, begin, end); });
+}
+
+template <typename... TComponents>
+const Registry::GroupData* Group<TComponents...>::_get_data() const {
+	ComponentMask mask;
+	(mask.set(get_component_id<TComponents>()), ...);
+
+	return _registry->_find_group(mask);
+}
+
+template <typename... TComponents>
+template <typename T>
+T* Group<TComponents...>::_get_owned_page(const Registry::GroupData& group, size_t page_idx) {
+	const uint32_t component_id = get_component_id<T>();
+	if (!group.owned.test(component_id)) {
+		return nullptr;
+	}
+
+	// Const components read the page without copying it from a snapshot
+	ComponentPool& pool = *_registry->_component_pools[component_id];
+	if constexpr (std::is_const_v<T>) {
+		return static_cast<T*>(std::as_const(pool).get_page(page_idx));
+	} else {
+		return static_cast<T*>(pool.get_page(page_idx));
+	}
+}
+
+template <typename... TComponents>
+template <typename Func>
+void Group<TComponents...>::_each_range(
+		const Registry::GroupData& group, Func& fn, uint32_t begin, uint32_t end) {
+	constexpr size_t PAGE_SIZE = ComponentPool::PAGE_SIZE;
+
+	// Every owned pool is in the same order, any of them has the entities
+	uint32_t first_owned = MAX_COMPONENTS;
+	group.owned.for_each(
+			[&](uint32_t component_id) { first_owned = std::min(first_owned, component_id); });
+	const ComponentPool& first_pool = *_registry->_component_pools[first_owned];
+
+	while (begin < end) {
+		const size_t page_idx = begin / PAGE_SIZE;
+		const uint32_t page_end = std::min<uint32_t>(end, (page_idx + 1) * PAGE_SIZE);
+
+		// Resolve the pages of the owned components once and walk them in
+		// lockstep, the others are looked up per entity
+		const Entity* entities = first_pool.get_entity_page(page_idx);
+		std::tuple<TComponents*...> columns = { _get_owned_page<TComponents>(group, page_idx)... };
+
+		for (uint32_t i = begin; i < page_end; i++) {
+			const Entity entity = entities[i % PAGE_SIZE];
+			fn(entity, (std::get<TComponents*>(columns)
+								   ? std::get<TComponents*>(columns)[i % PAGE_SIZE]
+								   : *_registry->template get<TComponents>(entity))...);
+		}
+
+		begin = page_end;
+	}
 }
 
 } //namespace gl
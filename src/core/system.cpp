@@ -0,0 +1,25 @@
+#include "core/system.h"
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+namespace gl {
+
+std::string System::get_name() const {
+	const char* name = typeid(*this).name();
+
+#ifdef __GNUG__
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+	if (status == 0 && demangled) {
+		std::string result = demangled;
+		std::free(demangled);
+		return result;
+	}
+#endif
+
+	return name;
+}
+
+} //namespace gl
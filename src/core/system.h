@@ -4,6 +4,35 @@
 
 namespace gl {
 
+/**
+ * Components a system reads and writes. World runs systems whose accesses
+ * don't conflict concurrently, so a non-exclusive system must stick to
+ * the declared components and defer structural changes (spawn, despawn,
+ * assign, remove) to Registry::get_command_buffer.
+ */
+struct SystemAccess {
+	ComponentMask reads;
+	ComponentMask writes;
+	// Changes the registry structure directly or needs the calling
+	// thread, such systems run alone
+	bool exclusive = false;
+
+	template <typename... TComponents> SystemAccess& read() {
+		(reads.set(get_component_id<TComponents>()), ...);
+		return *this;
+	}
+
+	template <typename... TComponents> SystemAccess& write() {
+		(writes.set(get_component_id<TComponents>()), ...);
+		return *this;
+	}
+
+	bool conflicts_with(const SystemAccess& other) const {
+		return exclusive || other.exclusive || (writes & (other.reads | other.writes)).any() ||
+				(other.writes & reads).any();
+	}
+};
+
 class System {
 public:
 	virtual ~System() = default;
@@ -11,6 +40,18 @@ public:
 	virtual void on_init(Registry& registry) {};
 	virtual void on_update(Registry& registry, float dt) {};
 	virtual void on_destroy(Registry& registry) {};
+
+	/**
+	 * Queried once when the system is added to a World, systems that don't
+	 * declare their accesses are exclusive
+	 */
+	virtual SystemAccess get_access() const { return SystemAccess{ .exclusive = true }; }
+
+	/**
+	 * Queried once when the system is added to a World, names its profiler
+	 * track. Defaults to the class name.
+	 */
+	virtual std::string get_name() const;
 };
 
 } //namespace gl
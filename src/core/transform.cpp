@@ -29,4 +29,13 @@ Mat4 Transform::to_mat4() const {
 	const Mat4 mat_S = Mat4::scale(scale);
 	return mat_T * mat_R * mat_S;
 }
+
+Transform interpolate(const Transform& from, const Transform& to, float alpha) {
+	Transform result;
+	result.position = from.position + (to.position - from.position) * alpha;
+	result.rotation = from.rotation + (to.rotation - from.rotation) * alpha;
+	result.scale = from.scale + (to.scale - from.scale) * alpha;
+	return result;
+}
+
 } //namespace gl
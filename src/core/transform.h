@@ -9,6 +9,11 @@
 
 namespace gl {
 
+/**
+ * Local placement of an entity. Systems modifying it after it was added
+ * call Registry::mark_changed<Transform> so that cached world matrices
+ * get updated.
+ */
 struct Transform {
 	Vec3f position = Vec3f::zero();
 	Vec3f rotation = Vec3f::zero();
@@ -27,4 +32,26 @@ struct Transform {
 
 inline constexpr Transform DEFAULT_TRANSFORM{};
 
+/**
+ * Blends every part of the transforms linearly, alpha of 0 yields from
+ */
+Transform interpolate(const Transform& from, const Transform& to, float alpha);
+
+/**
+ * Transform of the entity before the last fixed step, kept up to date by
+ * World. Rendering blends it with the current one by the interpolation
+ * alpha so that motion stays smooth between fixed steps.
+ */
+struct PreviousTransform {
+	Transform transform;
+};
+
+/**
+ * World space matrix of an entity, the local Transform combined with the
+ * ones of its ancestors. Written by TransformSystem.
+ */
+struct GlobalTransform {
+	Mat4 matrix = Mat4(1.0f);
+};
+
 } //namespace gl
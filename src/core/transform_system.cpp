@@ -0,0 +1,201 @@
+#include "core/transform_system.h"
+
+#include "core/assert.h"
+#include "core/hierarchy.h"
+#include "core/transform.h"
+
+namespace gl {
+
+static constexpr uint32_t UNKNOWN_DEPTH = UINT32_MAX;
+
+void TransformSystem::on_update(Registry& registry, float dt) {
+	// Collected first, assigning while iterating a view is not allowed
+	std::vector<Entity> missing;
+	for (Entity entity : registry.view<Transform, Without<GlobalTransform>>()) {
+		missing.push_back(entity);
+	}
+
+	for (Entity entity : missing) {
+		registry.assign<GlobalTransform>(entity);
+	}
+
+	if (_is_order_outdated(registry, !missing.empty())) {
+		_rebuild_order(registry);
+	}
+
+	if (!_propagate(registry)) {
+		_rebuild_order(registry);
+		_propagate(registry);
+	}
+}
+
+bool TransformSystem::_is_order_outdated(Registry& registry, bool globals_added) {
+	if (!_order_built || globals_added) {
+		return true;
+	}
+
+	// Despawned entities are reported as removed as well
+	if (!registry.get_removed<Transform>().empty() ||
+			!registry.get_removed<GlobalTransform>().empty() ||
+			!registry.get_removed<Parent>().empty()) {
+		return true;
+	}
+
+	const auto reparented = registry.view<Changed<Parent>>();
+	return reparented.begin() != reparented.end();
+}
+
+void TransformSystem::_rebuild_order(Registry& registry) {
+	std::vector<Entity> entities;
+	uint32_t index_count = 0;
+	for (Entity entity : registry.view<Transform, GlobalTransform>()) {
+		entities.push_back(entity);
+		index_count = std::max(index_count, get_entity_index(entity) + 1);
+	}
+
+	// Parents without a transform of their own do not contribute
+	std::vector<Entity> parents(index_count, INVALID_ENTITY_ID);
+	for (Entity entity : entities) {
+		const Entity parent = get_parent(registry, entity);
+		if (registry.has<Transform, GlobalTransform>(parent)) {
+			parents[get_entity_index(entity)] = parent;
+		}
+	}
+
+	std::vector<uint32_t> depths(index_count, UNKNOWN_DEPTH);
+	std::vector<uint32_t> chain;
+	uint32_t max_depth = 0;
+	for (Entity entity : entities) {
+		// Walk up until an ancestor of known depth or a root is found
+		uint32_t entity_idx = get_entity_index(entity);
+		while (depths[entity_idx] == UNKNOWN_DEPTH) {
+			chain.push_back(entity_idx);
+			GL_ASSERT(chain.size() <= entities.size(), "Cycle detected in entity hierarchy.");
+
+			const Entity parent = parents[entity_idx];
+			if (parent == INVALID_ENTITY_ID) {
+				break;
+			}
+			entity_idx = get_entity_index(parent);
+		}
+
+		uint32_t depth = depths[entity_idx] == UNKNOWN_DEPTH ? 0 : depths[entity_idx] + 1;
+		for (auto it = chain.rbegin(); it != chain.rend(); it++) {
+			depths[*it] = depth++;
+		}
+		max_depth = std::max(max_depth, depth);
+		chain.clear();
+	}
+
+	// Counting sort by depth, which gives the breadth first order
+	std::vector<uint32_t> offsets(max_depth + 1, 0);
+	for (Entity entity : entities) {
+		offsets[depths[get_entity_index(entity)] + 1]++;
+	}
+	for (uint32_t i = 1; i < offsets.size(); i++) {
+		offsets[i] += offsets[i - 1];
+	}
+
+	if (_resolved_parents.size() < index_count) {
+		_resolved_parents.resize(index_count, INVALID_ENTITY_ID);
+	}
+
+	_order.resize(entities.size());
+	for (Entity entity : entities) {
+		const uint32_t entity_idx = get_entity_index(entity);
+		const Entity parent = parents[entity_idx];
+
+		_order[offsets[depths[entity_idx]]++] = {
+			.entity = entity,
+			.parent = parent,
+			.reparented = _resolved_parents[entity_idx] != parent,
+		};
+		_resolved_parents[entity_idx] = parent;
+	}
+
+	_order_built = true;
+}
+
+bool TransformSystem::_propagate(Registry& registry) {
+	for (Node& node : _order) {
+		// Despawns trigger a rebuild, so only compaction leaves stale ids
+		if (!registry.is_valid(node.entity) ||
+				(node.parent != INVALID_ENTITY_ID && !registry.is_valid(node.parent))) {
+			return false;
+		}
+
+		bool dirty = node.reparented || registry.is_changed<Transform>(node.entity) ||
+				registry.is_added<GlobalTransform>(node.entity);
+		if (!dirty && node.parent != INVALID_ENTITY_ID) {
+			dirty = registry.is_changed<GlobalTransform>(node.parent);
+		}
+		node.reparented = false;
+
+		if (!dirty) {
+			continue;
+		}
+
+		auto [transform, global] = registry.get_many<const Transform, GlobalTransform>(node.entity);
+
+		global->matrix = transform->to_mat4();
+		if (node.parent != INVALID_ENTITY_ID) {
+			global->matrix =
+					registry.get<const GlobalTransform>(node.parent)->matrix * global->matrix;
+		}
+
+		registry.mark_changed<GlobalTransform>(node.entity);
+	}
+
+	return true;
+}
+
+void TransformInterpolator::begin_frame(float alpha) {
+	_frame++;
+	_alpha = alpha;
+}
+
+bool TransformInterpolator::resolve(const Registry& registry, Entity entity, Mat4& matrix) {
+	const uint32_t entity_idx = get_entity_index(entity);
+	if (entity_idx < _entries.size() && _entries[entity_idx].frame == _frame) {
+		matrix = _entries[entity_idx].matrix;
+		return _entries[entity_idx].interpolated;
+	}
+
+	const Transform* transform = registry.get<Transform>(entity);
+	const PreviousTransform* previous = registry.get<PreviousTransform>(entity);
+
+	// Same contributing parents as TransformSystem::_rebuild_order
+	const Parent* parent = registry.get<Parent>(entity);
+	const bool has_parent = transform && registry.has<GlobalTransform>(entity) && parent &&
+			registry.has<Transform, GlobalTransform>(parent->entity);
+
+	// Ancestors are resolved first, the recursion may grow _entries
+	Mat4 parent_matrix;
+	const bool parent_interpolated =
+			has_parent && resolve(registry, parent->entity, parent_matrix);
+
+	Entry entry;
+	entry.frame = _frame;
+	entry.interpolated = (transform && previous) || parent_interpolated;
+
+	if (entry.interpolated) {
+		entry.matrix = previous ? interpolate(previous->transform, *transform, _alpha).to_mat4()
+								: transform->to_mat4();
+		if (has_parent) {
+			if (!parent_interpolated) {
+				parent_matrix = registry.get<GlobalTransform>(parent->entity)->matrix;
+			}
+			entry.matrix = parent_matrix * entry.matrix;
+		}
+	}
+
+	if (entity_idx >= _entries.size()) {
+		_entries.resize(entity_idx + 1);
+	}
+	_entries[entity_idx] = entry;
+
+	matrix = entry.matrix;
+	return entry.interpolated;
+}
+
+} //namespace gl
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "core/system.h"
+#include "glgpu/matrix.h"
+
+namespace gl {
+
+/**
+ * Keeps GlobalTransform of every entity owning a Transform up to date.
+ * Entities are visited breadth first over an array sorted by hierarchy
+ * depth, which is only rebuilt when parents change, and only subtrees
+ * whose local transform or ancestors changed get recomputed, so writes
+ * to Transform must be followed by Registry::mark_changed.
+ */
+class TransformSystem : public System {
+public:
+	TransformSystem() = default;
+	virtual ~TransformSystem() = default;
+
+	void on_update(Registry& registry, float dt) override;
+
+private:
+	bool _is_order_outdated(Registry& registry, bool globals_added);
+
+	void _rebuild_order(Registry& registry);
+
+	/**
+	 * @returns false if the order refers to relocated entities and must
+	 * be rebuilt, see Registry::compact
+	 */
+	bool _propagate(Registry& registry);
+
+private:
+	struct Node {
+		Entity entity;
+		// Resolved parent, INVALID_ENTITY_ID for roots
+		Entity parent;
+		bool reparented;
+	};
+
+	// Parents always come before their children
+	std::vector<Node> _order;
+	// Parent each entity index was resolved to by the last rebuild
+	std::vector<Entity> _resolved_parents;
+	bool _order_built = false;
+};
+
+/**
+ * Resolves world matrices blended between the last two fixed steps for
+ * rendering, see PreviousTransform. An entity is blended when it or any
+ * ancestor moves in fixed steps, so children follow their interpolated
+ * parents. Parents contribute under the same rules as in TransformSystem.
+ * Results are memoized per entity until the next begin_frame.
+ */
+class TransformInterpolator {
+public:
+	void begin_frame(float alpha);
+
+	/**
+	 * @returns false if neither the entity nor its ancestors are
+	 * interpolated, GlobalTransform is up to date for it then
+	 */
+	bool resolve(const Registry& registry, Entity entity, Mat4& matrix);
+
+private:
+	struct Entry {
+		uint64_t frame = 0;
+		bool interpolated = false;
+		Mat4 matrix;
+	};
+
+	// By entity index, only valid for entries of the current frame
+	std::vector<Entry> _entries;
+	uint64_t _frame = 0;
+	float _alpha = 1.0f;
+};
+
+} //namespace gl
@@ -1,9 +1,18 @@
 #include "core/world.h"
 
+#include "core/assert.h"
 #include "core/system.h"
+#include "core/transform.h"
 
 namespace gl {
 
+World::World(StorageMode storage_mode, std::shared_ptr<JobSystem> job_system) :
+		Registry(storage_mode) {
+	set_job_system(job_system ? job_system : JobSystem::get_shared());
+
+	_profiler.add_track("frame");
+}
+
 World::~World() { cleanup(); }
 
 void World::cleanup() {
@@ -13,14 +22,200 @@ void World::cleanup() {
 }
 
 void World::update(float dt) {
-	for (auto& system : _systems) {
-		system->on_update(*this, dt);
+	GL_PROFILE_SCOPE("World::update");
+
+	const bool profiling = _profiler.is_enabled();
+	const Profiler::Clock::time_point frame_start =
+			profiling ? Profiler::Clock::now() : Profiler::Clock::time_point();
+
+	if (_schedule_outdated) {
+		_build_schedules();
 	}
+
+	if (!_fixed_schedule.empty()) {
+		_accumulator += dt;
+
+		uint32_t substeps = 0;
+		while (_accumulator >= _fixed_timestep && substeps < _max_substeps) {
+			_store_previous_transforms();
+			_run_schedule(_fixed_schedule, _fixed_timestep);
+
+			_accumulator -= _fixed_timestep;
+			substeps++;
+		}
+
+		// Falling behind, drop the whole steps that are left
+		if (_accumulator >= _fixed_timestep) {
+			_accumulator = std::fmod(_accumulator, _fixed_timestep);
+		}
+
+		_interpolation_alpha = _accumulator / _fixed_timestep;
+	}
+
+	_run_schedule(_schedule, dt);
+
+	// Component events of the whole frame are delivered as one batch
+	dispatch_observers();
+
+	// Removals every system has seen can be dropped
+	if (!_system_ticks.empty()) {
+		trim_removed(*std::min_element(_system_ticks.begin(), _system_ticks.end()));
+	}
+
+	if (profiling) {
+		_profiler.record(0, frame_start, Profiler::Clock::now());
+	}
+}
+
+void World::add_system(std::shared_ptr<System> system) { _add_system(system, false); }
+
+const std::vector<std::vector<uint32_t>>& World::get_schedule() {
+	if (_schedule_outdated) {
+		_build_schedules();
+	}
+
+	return _schedule;
+}
+
+void World::add_fixed_system(std::shared_ptr<System> system) { _add_system(system, true); }
+
+const std::vector<std::vector<uint32_t>>& World::get_fixed_schedule() {
+	if (_schedule_outdated) {
+		_build_schedules();
+	}
+
+	return _fixed_schedule;
+}
+
+void World::set_fixed_timestep(float step, uint32_t max_substeps) {
+	GL_ASSERT(step > 0.0f, "Fixed timestep must be positive");
+
+	_fixed_timestep = step;
+	_max_substeps = std::max(1u, max_substeps);
+	_accumulator = std::min(_accumulator, step);
+}
+
+float World::get_fixed_timestep() const { return _fixed_timestep; }
+
+uint32_t World::get_max_substeps() const { return _max_substeps; }
+
+void World::set_job_system(std::shared_ptr<JobSystem> job_system) {
+	_jobs = job_system;
+	_job_system = _jobs.get();
 }
 
-void World::add_system(std::shared_ptr<System> system) {
+Profiler& World::get_profiler() { return _profiler; }
+
+void World::_add_system(std::shared_ptr<System> system, bool fixed) {
 	system->on_init(*this);
 	_systems.push_back(system);
+	_system_accesses.push_back(system->get_access());
+	_system_fixed.push_back(fixed);
+	_system_ticks.push_back(0);
+	_profiler.add_track(system->get_name());
+
+	_schedule_outdated = true;
+}
+
+void World::_build_schedules() {
+	// A system runs one stage after the latest earlier system it conflicts
+	// with, which keeps the insertion order between conflicting systems
+	std::vector<uint32_t> stages(_systems.size(), 0);
+	uint32_t stage_count[2] = {};
+
+	for (size_t i = 0; i < _systems.size(); i++) {
+		for (size_t j = 0; j < i; j++) {
+			if (_system_fixed[i] == _system_fixed[j] &&
+					_system_accesses[i].conflicts_with(_system_accesses[j])) {
+				stages[i] = std::max(stages[i], stages[j] + 1);
+			}
+		}
+
+		stage_count[_system_fixed[i]] = std::max(stage_count[_system_fixed[i]], stages[i] + 1);
+	}
+
+	_schedule.assign(stage_count[0], {});
+	_fixed_schedule.assign(stage_count[1], {});
+	for (uint32_t i = 0; i < _systems.size(); i++) {
+		(_system_fixed[i] ? _fixed_schedule : _schedule)[stages[i]].push_back(i);
+	}
+
+	_schedule_outdated = false;
+}
+
+void World::_run_schedule(const std::vector<std::vector<uint32_t>>& schedule, float dt) {
+	for (const std::vector<uint32_t>& stage : schedule) {
+		// Only report changes made since the systems last ran, systems
+		// sharing a stage ran at the same tick unless the schedule changed
+		uint32_t last_tick = UINT32_MAX;
+		for (uint32_t system_idx : stage) {
+			last_tick = std::min(last_tick, _system_ticks[system_idx]);
+		}
+		set_last_change_tick(last_tick);
+
+		_run_stage(stage, dt);
+
+		// Sync point for structural changes deferred by the systems
+		flush_commands();
+
+		for (uint32_t system_idx : stage) {
+			_system_ticks[system_idx] = get_change_tick();
+		}
+		advance_change_tick();
+	}
+}
+
+void World::_run_stage(const std::vector<uint32_t>& stage, float dt) {
+	// Exclusive systems always end up alone and stay on the calling thread
+	if (stage.size() == 1) {
+		_run_system(stage[0], dt);
+		return;
+	}
+
+	// Systems may read through mutable access, which detaches storage
+	// shared with snapshots, and systems declaring the same component would
+	// race on that
+	ComponentMask accessed;
+	for (uint32_t system_idx : stage) {
+		accessed = accessed | _system_accesses[system_idx].reads |
+				_system_accesses[system_idx].writes;
+	}
+	_detach_storage(accessed);
+
+	_structure_locked = true;
+
+	try {
+		_jobs->parallel_for(stage.size(), 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) {
+				_run_system(stage[i], dt);
+			}
+		});
+	} catch (...) {
+		_structure_locked = false;
+		throw;
+	}
+
+	_structure_locked = false;
+}
+
+void World::_run_system(uint32_t system_idx, float dt) {
+	if (!_profiler.is_enabled()) {
+		_systems[system_idx]->on_update(*this, dt);
+		return;
+	}
+
+	// Every system has a track of its own, so concurrent systems never
+	// record to the same one
+	const Profiler::Clock::time_point start = Profiler::Clock::now();
+	_systems[system_idx]->on_update(*this, dt);
+	_profiler.record(system_idx + 1, start, Profiler::Clock::now());
+}
+
+void World::_store_previous_transforms() {
+	par_each<const Transform, PreviousTransform>(
+			[](Entity entity, const Transform& transform, PreviousTransform& previous) {
+				previous.transform = transform;
+			});
 }
 
 } //namespace gl
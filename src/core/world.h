@@ -1,23 +1,109 @@
 #pragma once
 
+#include "core/profiler.h"
 #include "core/registry.h"
 
 namespace gl {
 
 class System;
+struct SystemAccess;
 
 class World : public Registry {
 public:
+	static constexpr float DEFAULT_FIXED_TIMESTEP = 1.0f / 60.0f;
+	static constexpr uint32_t DEFAULT_MAX_SUBSTEPS = 8;
+
+	/**
+	 * Runs on the process wide JobSystem::get_shared unless a pool is given
+	 */
+	World(StorageMode storage_mode = StorageMode::POOLED,
+			std::shared_ptr<JobSystem> job_system = nullptr);
 	virtual ~World();
 
 	void cleanup();
 
+	/**
+	 * Runs the fixed step systems once for every whole step accumulated,
+	 * up to the substep limit, and the other systems once with dt
+	 */
 	void update(float dt);
 
+	/**
+	 * Adds a system to the end of the schedule. Systems run in the order
+	 * they were added unless their SystemAccess declarations don't
+	 * conflict, then they may run concurrently on the job system.
+	 */
 	void add_system(std::shared_ptr<System> system);
 
+	/**
+	 * Indices of the systems run by every stage, in execution order.
+	 * Systems of a stage run concurrently, structural changes they defer
+	 * are flushed between stages.
+	 */
+	const std::vector<std::vector<uint32_t>>& get_schedule();
+
+	/**
+	 * Adds a system that runs with a constant dt of the fixed timestep,
+	 * before the systems added by add_system
+	 */
+	void add_fixed_system(std::shared_ptr<System> system);
+
+	/**
+	 * Same as get_schedule for the fixed step systems
+	 */
+	const std::vector<std::vector<uint32_t>>& get_fixed_schedule();
+
+	/**
+	 * Frame time beyond max_substeps steps is dropped instead of being
+	 * caught up later, so slow steps can't snowball
+	 */
+	void set_fixed_timestep(float step, uint32_t max_substeps = DEFAULT_MAX_SUBSTEPS);
+
+	float get_fixed_timestep() const;
+
+	uint32_t get_max_substeps() const;
+
+	/**
+	 * Replaces the thread pool used for parallel iteration, allowing
+	 * multiple worlds to share the same workers.
+	 */
+	void set_job_system(std::shared_ptr<JobSystem> job_system);
+
+	/**
+	 * Timings of the whole update on track 0 and of every system on the
+	 * track after its index, disabled by default
+	 */
+	Profiler& get_profiler();
+
+private:
+	void _add_system(std::shared_ptr<System> system, bool fixed);
+
+	void _build_schedules();
+
+	void _run_schedule(const std::vector<std::vector<uint32_t>>& schedule, float dt);
+
+	void _run_stage(const std::vector<uint32_t>& stage, float dt);
+
+	void _run_system(uint32_t system_idx, float dt);
+
+	void _store_previous_transforms();
+
 private:
 	std::vector<std::shared_ptr<System>> _systems;
+	std::vector<SystemAccess> _system_accesses;
+	std::vector<bool> _system_fixed;
+	// Change tick each system last ran at, see Registry::set_last_change_tick
+	std::vector<uint32_t> _system_ticks;
+	std::vector<std::vector<uint32_t>> _schedule;
+	std::vector<std::vector<uint32_t>> _fixed_schedule;
+	bool _schedule_outdated = false;
+
+	float _fixed_timestep = DEFAULT_FIXED_TIMESTEP;
+	uint32_t _max_substeps = DEFAULT_MAX_SUBSTEPS;
+	// Frame time not simulated by fixed steps yet
+	float _accumulator = 0.0f;
+	std::shared_ptr<JobSystem> _jobs;
+	Profiler _profiler;
 };
 
 } //namespace gl
@@ -0,0 +1,165 @@
+#include "core/world_batch.h"
+
+#include "core/assert.h"
+#include "core/system.h"
+
+namespace gl {
+
+static uint32_t _get_float_count(FieldType type) {
+	switch (type) {
+		case FieldType::VEC2F:
+		case FieldType::VEC2U:
+			return 2;
+		case FieldType::VEC3F:
+		case FieldType::VEC3U:
+			return 3;
+		case FieldType::MAT4:
+			return 16;
+		case FieldType::BYTES:
+			return 0;
+		default:
+			return 1;
+	}
+}
+
+template <typename T> static void _convert(const uint8_t* src, float* dst, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		T value;
+		std::memcpy(&value, src + i * sizeof(T), sizeof(T));
+		dst[i] = static_cast<float>(value);
+	}
+}
+
+static void _write_field(FieldType type, const uint8_t* src, float* dst) {
+	const uint32_t count = _get_float_count(type);
+
+	switch (type) {
+		case FieldType::BOOL:
+			_convert<bool>(src, dst, count);
+			break;
+		case FieldType::INT32:
+			_convert<int32_t>(src, dst, count);
+			break;
+		case FieldType::UINT32:
+		case FieldType::VEC2U:
+		case FieldType::VEC3U:
+			_convert<uint32_t>(src, dst, count);
+			break;
+		case FieldType::INT64:
+			_convert<int64_t>(src, dst, count);
+			break;
+		case FieldType::UINT64:
+			_convert<uint64_t>(src, dst, count);
+			break;
+		case FieldType::DOUBLE:
+			_convert<double>(src, dst, count);
+			break;
+		default:
+			std::memcpy(dst, src, count * sizeof(float));
+			break;
+	}
+}
+
+WorldBatch::WorldBatch(
+		uint32_t world_count, StorageMode storage_mode, std::shared_ptr<JobSystem> job_system) :
+		_jobs(job_system ? job_system : std::make_shared<JobSystem>()) {
+	// A single pool for all worlds, a pool per world would oversubscribe
+	// the cores many times over
+	_worlds.reserve(world_count);
+	for (uint32_t i = 0; i < world_count; i++) {
+		_worlds.push_back(std::make_unique<World>(storage_mode, _jobs));
+	}
+
+	_observed_counts.resize(world_count, 0);
+}
+
+uint32_t WorldBatch::get_world_count() const { return _worlds.size(); }
+
+World& WorldBatch::get_world(uint32_t world_idx) {
+	GL_ASSERT(world_idx < _worlds.size(), "World index out of range");
+	return *_worlds[world_idx];
+}
+
+void WorldBatch::add_system(const SystemFactory& factory) {
+	for (auto& world : _worlds) {
+		world->add_system(factory());
+	}
+}
+
+void WorldBatch::add_fixed_system(const SystemFactory& factory) {
+	for (auto& world : _worlds) {
+		world->add_fixed_system(factory());
+	}
+}
+
+void WorldBatch::set_fixed_timestep(float step, uint32_t max_substeps) {
+	for (auto& world : _worlds) {
+		world->set_fixed_timestep(step, max_substeps);
+	}
+}
+
+void WorldBatch::step(float dt, uint32_t step_count) {
+	_jobs->parallel_for(_worlds.size(), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t world_idx = begin; world_idx < end; world_idx++) {
+			for (uint32_t i = 0; i < step_count; i++) {
+				_worlds[world_idx]->update(dt);
+			}
+
+			_gather_observations(world_idx);
+		}
+	});
+}
+
+void WorldBatch::set_observation(std::vector<ObservationField> fields, uint32_t max_entities) {
+	_observation_fields = std::move(fields);
+	_observation_mask.reset();
+	_observation_size = 0;
+
+	for (const ObservationField& field : _observation_fields) {
+		GL_ASSERT(field.field.type != FieldType::BYTES, "Field can not be converted to floats");
+
+		_observation_mask.set(field.component_id);
+		_observation_size += _get_float_count(field.field.type);
+	}
+
+	_max_observed_entities = max_entities;
+	_observations.assign(
+			(size_t)_worlds.size() * _max_observed_entities * _observation_size, 0.0f);
+	std::fill(_observed_counts.begin(), _observed_counts.end(), 0);
+}
+
+uint32_t WorldBatch::get_observation_size() const { return _observation_size; }
+
+uint32_t WorldBatch::get_max_observed_entities() const { return _max_observed_entities; }
+
+std::span<const float> WorldBatch::get_observations() const { return _observations; }
+
+std::span<const uint32_t> WorldBatch::get_observed_counts() const { return _observed_counts; }
+
+void WorldBatch::_gather_observations(uint32_t world_idx) {
+	if (_observation_fields.empty()) {
+		return;
+	}
+
+	World& world = *_worlds[world_idx];
+	const std::vector<Entity>& entities = world.query(_observation_mask);
+	const uint32_t count = std::min<size_t>(entities.size(), _max_observed_entities);
+
+	const size_t world_floats = (size_t)_max_observed_entities * _observation_size;
+	float* dst = _observations.data() + world_idx * world_floats;
+
+	for (uint32_t i = 0; i < count; i++) {
+		for (const ObservationField& field : _observation_fields) {
+			// Read only, pages shared with snapshots stay shared
+			const uint8_t* component = static_cast<const uint8_t*>(
+					std::as_const(world).get(entities[i], field.component_id));
+			_write_field(field.field.type, component + field.field.offset, dst);
+			dst += _get_float_count(field.field.type);
+		}
+	}
+
+	std::fill(dst, _observations.data() + (world_idx + 1) * world_floats, 0.0f);
+	_observed_counts[world_idx] = count;
+}
+
+} //namespace gl
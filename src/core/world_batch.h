@@ -0,0 +1,97 @@
+/**
+ * @file world_batch.h
+ */
+
+#pragma once
+
+#include "core/component_registry.h"
+#include "core/world.h"
+
+namespace gl {
+
+/**
+ * Field of a component copied into the observation buffer, converted to
+ * floats. Vectors and matrices take one float per element.
+ */
+struct ObservationField {
+	uint32_t component_id;
+	FieldInfo field;
+};
+
+/**
+ * Independent worlds with identical systems, stepped together across the
+ * threads of one shared job system. Meant for many small simulations such
+ * as reinforcement learning rollouts, where stepping every world on its
+ * own would be dominated by dispatch overhead.
+ */
+class WorldBatch {
+public:
+	typedef std::function<std::shared_ptr<System>()> SystemFactory;
+
+	WorldBatch(uint32_t world_count, StorageMode storage_mode = StorageMode::POOLED,
+			std::shared_ptr<JobSystem> job_system = nullptr);
+
+	uint32_t get_world_count() const;
+
+	World& get_world(uint32_t world_idx);
+
+	/**
+	 * Adds a system created by factory to every world, systems keep
+	 * per-world state so each world gets an instance of its own
+	 */
+	void add_system(const SystemFactory& factory);
+
+	void add_fixed_system(const SystemFactory& factory);
+
+	void set_fixed_timestep(float step, uint32_t max_substeps = World::DEFAULT_MAX_SUBSTEPS);
+
+	/**
+	 * Updates every world step_count times with dt, then gathers the
+	 * observations. Worlds are processed in parallel, so systems must not
+	 * share mutable state between worlds.
+	 */
+	void step(float dt, uint32_t step_count = 1);
+
+	/**
+	 * Selects what step writes to the observation buffer: the listed
+	 * fields of the first max_entities entities that own every listed
+	 * component, in the order of the cached query on those components.
+	 * Rows of missing entities are zeroed.
+	 */
+	void set_observation(std::vector<ObservationField> fields, uint32_t max_entities);
+
+	/**
+	 * Floats written per observed entity
+	 */
+	uint32_t get_observation_size() const;
+
+	uint32_t get_max_observed_entities() const;
+
+	/**
+	 * world_count * max_entities * observation_size floats gathered by the
+	 * last step, laid out world by world
+	 */
+	std::span<const float> get_observations() const;
+
+	/**
+	 * Number of entities observed in every world by the last step
+	 */
+	std::span<const uint32_t> get_observed_counts() const;
+
+private:
+	void _gather_observations(uint32_t world_idx);
+
+private:
+	std::shared_ptr<JobSystem> _jobs;
+	std::vector<std::unique_ptr<World>> _worlds;
+
+	std::vector<ObservationField> _observation_fields;
+	ComponentMask _observation_mask;
+	uint32_t _observation_size = 0;
+	uint32_t _max_observed_entities = 0;
+
+	std::vector<float> _observations;
+	std::vector<uint32_t> _observed_counts;
+};
+
+} //namespace gl
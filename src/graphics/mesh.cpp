@@ -1,5 +1,7 @@
 #include "graphics/mesh.h"
 
+#include "core/profiler.h"
+
 namespace gl {
 
 StaticMesh::~StaticMesh() {
@@ -34,6 +36,8 @@ static AABB _get_aabb_from_vertices(std::span<const MeshVertex> vertices) {
 }
 
 void StaticMesh::upload(std::span<const MeshVertex> vertices, std::span<const uint32_t> indices) {
+	GL_PROFILE_SCOPE("StaticMesh::upload");
+
 	const size_t vertex_size = vertices.size() * sizeof(MeshVertex);
 	const size_t index_size = indices.size() * sizeof(uint32_t);
 	const size_t data_size = vertex_size + index_size;
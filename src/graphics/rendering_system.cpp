@@ -3,6 +3,7 @@
 #include "core/components.h"
 #include "core/event_system.h"
 #include "core/gpu_context.h"
+#include "core/profiler.h"
 #include "core/transform.h"
 #include "glgpu/color.h"
 #include "glgpu/types.h"
@@ -57,6 +58,10 @@ void RenderingSystem::on_init(Registry& registry) {
 
 void RenderingSystem::on_destroy(Registry& registry) {}
 
+void RenderingSystem::set_transform_caching(bool enabled) { _transform_caching = enabled; }
+
+bool RenderingSystem::is_transform_caching() const { return _transform_caching; }
+
 void RenderingSystem::on_update(Registry& registry, float dt) {
 	// Wait for previous frame to be submitted
 	_renderer->wait_for_frame();
@@ -114,34 +119,80 @@ void RenderingSystem::_execute_geometry_pass(const FrameContext& ctx, Registry&
 	_backend->command_bind_graphics_pipeline(ctx.cmd, _pipeline->pipeline);
 	_backend->command_bind_uniform_sets(ctx.cmd, _pipeline->shader, 0, { _material_set });
 
-	for (Entity entity : registry.view<Transform, MeshComponent>()) {
-		auto [transform, mc] = registry.get_many<Transform, MeshComponent>(entity);
+	// Walks the mesh pool as a packed array, Transform is looked up per
+	// entity if the physics group owns it already. Only read, so storage
+	// shared with snapshots stays shared.
+	Group<const Transform, const MeshComponent> drawables =
+			registry.group<const Transform, const MeshComponent>();
+
+	// Keep draws sharing a mesh next to each other, sorting is only needed
+	// once meshes got added, changed or removed. Grouped entities are
+	// reordered among themselves.
+
+	const auto changed_meshes = registry.view<Changed<MeshComponent>>();
+	if (changed_meshes.begin() != changed_meshes.end() ||
+			!registry.get_removed<MeshComponent>().empty()) {
+		registry.sort<MeshComponent>([](const MeshComponent& lhs, const MeshComponent& rhs) {
+			return lhs.type < rhs.type;
+		});
+	}
+
+	StaticMesh* bound_mesh = nullptr;
 
-		std::shared_ptr<StaticMesh> mesh = _resolve_mesh(mc->type);
+	_interpolator.begin_frame(registry.get_interpolation_alpha());
+
+	GL_PROFILE_SCOPE("RenderingSystem::cull_and_draw");
+
+	drawables.each([&](Entity entity, const Transform& transform, const MeshComponent& mc) {
+		std::shared_ptr<StaticMesh> mesh = _resolve_mesh(mc.type);
 		if (!mesh) {
-			continue;
+			return;
 		}
 
-		const Mat4 transform_mat = transform->to_mat4();
+		const uint32_t entity_idx = get_entity_index(entity);
+		if (entity_idx >= _draw_cache.size()) {
+			_draw_cache.resize(entity_idx + 1);
+		}
+
+		// Static scenery keeps its cached matrix and bounds when caching
+		DrawCache& cache = _draw_cache[entity_idx];
+		Mat4 blended;
+		if (_interpolator.resolve(registry, entity, blended)) {
+			// Moved by fixed steps itself or through an ancestor, blended
+			// anew every frame
+			cache.transform = blended;
+			cache.aabb = mesh->aabb.transform(cache.transform);
+		} else if (!_transform_caching || registry.is_changed<Transform>(entity) ||
+				registry.is_changed<GlobalTransform>(entity) ||
+				registry.is_changed<MeshComponent>(entity)) {
+			// Hierarchies are resolved by TransformSystem when present
+			const GlobalTransform* global = registry.get<const GlobalTransform>(entity);
+			cache.transform = global ? global->matrix : transform.to_mat4();
+			cache.aabb = mesh->aabb.transform(cache.transform);
+		}
 
 		// If objects is not inside of the view frustum, discard it.
-		const AABB aabb = mesh->aabb.transform(transform_mat);
-		if (!aabb.is_inside_frustum(ctx.frustum)) {
-			continue;
+		if (!cache.aabb.is_inside_frustum(ctx.frustum)) {
+			return;
 		}
 
 		// Push constants
 		PushConstants pc = {};
-		pc.transform = transform_mat;
+		pc.transform = cache.transform;
 		pc.vertex_buffer_addr = mesh->vertex_buffer_address;
 		pc.scene_buffer_addr = _scene_buffer_addr;
 
-		_backend->command_push_constants(ctx.cmd, _pipeline->shader, 0, sizeof(PushConstants), &pc);
+		_backend->command_push_constants(
+				ctx.cmd, _pipeline->shader, 0, sizeof(PushConstants), &pc);
 
 		// Draw call
-		_backend->command_bind_index_buffer(ctx.cmd, mesh->index_buffer, 0, IndexType::UINT32);
+		if (mesh.get() != bound_mesh) {
+			_backend->command_bind_index_buffer(
+					ctx.cmd, mesh->index_buffer, 0, IndexType::UINT32);
+			bound_mesh = mesh.get();
+		}
 		_backend->command_draw_indexed(ctx.cmd, mesh->index_count);
-	}
+	});
 }
 
 void RenderingSystem::_init_pipelines() {
@@ -200,8 +251,8 @@ Mat4 RenderingSystem::_get_camera_viewproj(Registry& registry, Image target_imag
 	}
 
 	Mat4 viewproj = Mat4(1.0f);
-	for (Entity entity : registry.view<Transform, CameraComponent>()) {
-		auto [transform, cc] = registry.get_many<Transform, CameraComponent>(entity);
+	for (Entity entity : registry.query<Transform, CameraComponent>()) {
+		auto [transform, cc] = registry.get_many<const Transform, CameraComponent>(entity);
 
 		if (!cc->enabled) {
 			continue;
@@ -3,6 +3,7 @@
 #include "core/components.h"
 #include "core/gpu_context.h"
 #include "core/system.h"
+#include "core/transform_system.h"
 #include "glgpu/backend.h"
 #include "glgpu/matrix.h"
 #include "glgpu/types.h"
@@ -26,6 +27,16 @@ public:
 	void on_update(Registry& registry, float dt) override;
 	void on_destroy(Registry& registry) override;
 
+	/**
+	 * Reuses world matrices and bounds of entities whose Transform,
+	 * GlobalTransform and MeshComponent didn't change. Only enable it when
+	 * every write to those components calls Registry::mark_changed,
+	 * otherwise stale placements get drawn. Disabled by default.
+	 */
+	void set_transform_caching(bool enabled);
+
+	bool is_transform_caching() const;
+
 private:
 	// Render Passes
 
@@ -80,6 +91,17 @@ private:
 		std::shared_ptr<StaticMesh> plane;
 		std::shared_ptr<StaticMesh> sphere;
 	} _primitives;
+
+	// World matrices and bounds by entity index, only recomputed when the
+	// transform or mesh of the entity changes if caching is enabled
+	struct DrawCache {
+		Mat4 transform;
+		AABB aabb;
+	};
+	std::vector<DrawCache> _draw_cache;
+	bool _transform_caching = false;
+
+	TransformInterpolator _interpolator;
 };
 
 } //namespace gl
@@ -4,6 +4,7 @@
 #include "core/event_system.h"
 #include "core/input.h"
 #include "core/log.h"
+#include "core/profiler.h"
 #include "glgpu/types.h"
 
 #include <SDL2/SDL.h>
@@ -83,6 +84,8 @@ Window::~Window() {
 bool Window::should_close() const { return _window_should_close; }
 
 void Window::poll_events() const {
+	GL_PROFILE_SCOPE("Window::poll_events");
+
 	SDL_Event e;
 	while (SDL_PollEvent(&e) != 0) {
 		if (e.type == SDL_QUIT) {
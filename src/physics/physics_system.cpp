@@ -11,40 +11,40 @@ void PhysicsSystem::on_init(Registry& registry) {}
 
 void PhysicsSystem::on_destroy(Registry& registry) {}
 
-void PhysicsSystem::on_update(Registry& registry, float dt) {
-	// 60Hz
-	constexpr float TIME_STEP = 1.0f / 60.0f;
-	// One collision check in every 60 frames.
-	constexpr int COLLISION_STEPS = 1;
+SystemAccess PhysicsSystem::get_access() const {
+	return SystemAccess().write<Transform, Rigidbody>();
+}
 
-	// Update physics engine
-	_integration_phase(registry, TIME_STEP);
+void PhysicsSystem::on_update(Registry& registry, float dt) {
+	// Steps by dt, add with World::add_fixed_system for a stable rate
+	_integration_phase(registry, dt);
 }
 
 void PhysicsSystem::_integration_phase(Registry& registry, float ts) {
-	for (Entity entity : registry.view<Transform, Rigidbody>()) {
-		auto [transform, rb] = registry.get_many<Transform, Rigidbody>(entity);
-
-		if (rb->is_static) {
-			continue;
-		}
-
-		// TODO: proper precision
-		Vec3f linear_acc = rb->force_acc / (rb->mass == 0.0f ? 0.0001f : rb->mass);
-		if (rb->use_gravity) {
-			linear_acc = linear_acc + Vec3f(0, -9.81f, 0);
-		}
-
-		// Update velocity
-		rb->velocity += linear_acc * ts;
-		rb->velocity *= std::pow(1.0f - rb->linear_damping, ts);
-
-		// Update transform
-		transform->position += rb->velocity * ts;
-
-		// Clear accumulators
-		rb->force_acc = Vec3f::zero();
-	}
+	// Owning group so the loop walks both pools as parallel arrays
+	registry.group<Transform, Rigidbody>().par_each(
+			[ts, &registry](Entity entity, Transform& transform, Rigidbody& rb) {
+				if (rb.is_static) {
+					return;
+				}
+
+				// TODO: proper precision
+				Vec3f linear_acc = rb.force_acc / (rb.mass == 0.0f ? 0.0001f : rb.mass);
+				if (rb.use_gravity) {
+					linear_acc = linear_acc + Vec3f(0, -9.81f, 0);
+				}
+
+				// Update velocity
+				rb.velocity += linear_acc * ts;
+				rb.velocity *= std::pow(1.0f - rb.linear_damping, ts);
+
+				// Update transform
+				transform.position += rb.velocity * ts;
+				registry.mark_changed<Transform>(entity);
+
+				// Clear accumulators
+				rb.force_acc = Vec3f::zero();
+			});
 }
 
 } //namespace gl
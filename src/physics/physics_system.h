@@ -14,6 +14,8 @@ public:
 	void on_update(Registry& registry, float dt) override;
 	void on_destroy(Registry& registry) override;
 
+	SystemAccess get_access() const override;
+
 private:
 	void _integration_phase(Registry& registry, float ts);
 
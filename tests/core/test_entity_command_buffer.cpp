@@ -0,0 +1,153 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/entity_command_buffer.h"
+#include "core/job_system.h"
+
+using namespace gl;
+
+struct Health {
+	int value = 0;
+};
+
+struct Tracked {
+	std::shared_ptr<int> handle;
+};
+
+TEST_CASE("Entity command buffer", "[core]") {
+	Registry registry;
+
+	SECTION("Commands are deferred until applied") {
+		Entity entity = registry.spawn();
+
+		EntityCommandBuffer commands;
+		commands.assign<Health>(entity, { 10 });
+
+		REQUIRE(!registry.has<Health>(entity));
+
+		commands.apply(registry);
+
+		REQUIRE(commands.is_empty());
+		REQUIRE(registry.get<Health>(entity)->value == 10);
+
+		commands.remove<Health>(entity);
+		commands.apply(registry);
+
+		REQUIRE(!registry.has<Health>(entity));
+
+		commands.despawn(entity);
+		commands.apply(registry);
+
+		REQUIRE(!registry.is_valid(entity));
+	}
+
+	SECTION("Placeholders resolve to spawned entities") {
+		EntityCommandBuffer commands;
+
+		Entity placeholder = commands.spawn();
+		REQUIRE(EntityCommandBuffer::is_pending(placeholder));
+
+		commands.assign<Health>(placeholder, { 5 });
+		commands.apply(registry);
+
+		uint32_t count = 0;
+		for (Entity entity : registry.view<Health>()) {
+			REQUIRE(!EntityCommandBuffer::is_pending(entity));
+			REQUIRE(registry.get<Health>(entity)->value == 5);
+			count++;
+		}
+		REQUIRE(count == 1);
+	}
+
+	SECTION("Structural changes can be recorded while iterating") {
+		for (int i = 0; i < 100; i++) {
+			registry.assign<Health>(registry.spawn())->value = i;
+		}
+
+		EntityCommandBuffer& commands = registry.get_command_buffer();
+		REQUIRE(&commands == &registry.get_command_buffer());
+
+		// The buffer cached by the thread belongs to a single registry
+		{
+			Registry other;
+			REQUIRE(&other.get_command_buffer() != &commands);
+			REQUIRE(&commands == &registry.get_command_buffer());
+		}
+
+		for (Entity entity : registry.view<Health>()) {
+			if (registry.get<Health>(entity)->value % 2 == 0) {
+				commands.despawn(entity);
+			}
+		}
+		registry.flush_commands();
+
+		REQUIRE(registry.count<Health>() == 50);
+		for (Entity entity : registry.view<Health>()) {
+			REQUIRE(registry.get<Health>(entity)->value % 2 == 1);
+		}
+	}
+
+	SECTION("Buffers recorded on worker threads are merged") {
+		JobSystem jobs(4);
+
+		std::vector<Entity> entities;
+		for (int i = 0; i < 1000; i++) {
+			entities.push_back(registry.spawn());
+		}
+
+		jobs.parallel_for(entities.size(), 16, [&](uint32_t begin, uint32_t end) {
+			EntityCommandBuffer& commands = registry.get_command_buffer();
+			for (uint32_t i = begin; i < end; i++) {
+				commands.assign<Health>(entities[i], { static_cast<int>(i) });
+			}
+		});
+		registry.flush_commands();
+
+		REQUIRE(registry.count<Health>() == 1000);
+		for (uint32_t i = 0; i < entities.size(); i++) {
+			REQUIRE(registry.get<Health>(entities[i])->value == static_cast<int>(i));
+		}
+	}
+
+	SECTION("Entities reserved on worker threads") {
+		JobSystem jobs(4);
+
+		// Half of the reservations recycle despawned slots
+		std::vector<Entity> despawned(500);
+		registry.spawn_many(despawned);
+		registry.despawn_many(despawned);
+
+		std::vector<Entity> entities(1000);
+		jobs.parallel_for(entities.size(), 16, [&](uint32_t begin, uint32_t end) {
+			EntityCommandBuffer& commands = registry.get_command_buffer();
+			for (uint32_t i = begin; i < end; i++) {
+				entities[i] = registry.reserve_entity();
+				commands.assign<Health>(entities[i], { static_cast<int>(i) });
+			}
+		});
+
+		REQUIRE(!registry.is_valid(entities[0]));
+		registry.flush_commands();
+
+		REQUIRE(std::set<Entity>(entities.begin(), entities.end()).size() == entities.size());
+		for (uint32_t i = 0; i < entities.size(); i++) {
+			REQUIRE(registry.is_valid(entities[i]));
+			REQUIRE(registry.get<Health>(entities[i])->value == static_cast<int>(i));
+		}
+
+		for (Entity entity : despawned) {
+			REQUIRE(!registry.is_valid(entity));
+		}
+	}
+
+	SECTION("Discarded payloads are destroyed") {
+		auto handle = std::make_shared<int>(0);
+
+		{
+			EntityCommandBuffer commands;
+			commands.assign<Tracked>(registry.spawn(), { handle });
+			REQUIRE(handle.use_count() == 2);
+		}
+
+		REQUIRE(handle.use_count() == 1);
+	}
+}
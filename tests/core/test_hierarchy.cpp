@@ -0,0 +1,181 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/hierarchy.h"
+#include "core/transform.h"
+#include "core/transform_system.h"
+#include "core/world.h"
+
+using namespace gl;
+
+TEST_CASE("Entity hierarchy", "[core]") {
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		World world(mode);
+		world.add_system(std::make_shared<TransformSystem>());
+
+		Entity root = world.spawn();
+		world.assign<Transform>(root)->position = Vec3f(1.0f, 0.0f, 0.0f);
+
+		Entity arm = world.spawn();
+		world.assign<Transform>(arm)->position = Vec3f(0.0f, 2.0f, 0.0f);
+
+		Entity hand = world.spawn();
+		world.assign<Transform>(hand)->scale = Vec3f(2.0f, 2.0f, 2.0f);
+
+		Entity other = world.spawn();
+		world.assign<Transform>(other);
+
+		set_parent(world, hand, arm);
+		set_parent(world, arm, root);
+
+		REQUIRE(get_parent(world, hand) == arm);
+		REQUIRE(get_parent(world, root) == INVALID_ENTITY_ID);
+		REQUIRE(world.get<Children>(root)->entities == std::vector<Entity>{ arm });
+
+		const auto global = [&](Entity entity) {
+			return world.get<GlobalTransform>(entity)->matrix;
+		};
+
+		world.update(0.016f);
+
+		REQUIRE(global(root) == world.get<Transform>(root)->to_mat4());
+		REQUIRE(global(arm) == global(root) * world.get<Transform>(arm)->to_mat4());
+		REQUIRE(global(hand) == global(arm) * world.get<Transform>(hand)->to_mat4());
+
+		SECTION("Only dirty subtrees are recomputed") {
+			world.get<Transform>(arm)->position = Vec3f(0.0f, 3.0f, 0.0f);
+			world.mark_changed<Transform>(arm);
+
+			world.update(0.016f);
+
+			REQUIRE(!world.is_changed<GlobalTransform>(root));
+			REQUIRE(!world.is_changed<GlobalTransform>(other));
+			REQUIRE(world.is_changed<GlobalTransform>(arm));
+			REQUIRE(world.is_changed<GlobalTransform>(hand));
+			REQUIRE(global(hand) == global(arm) * world.get<Transform>(hand)->to_mat4());
+
+			world.update(0.016f);
+
+			REQUIRE(!world.is_changed<GlobalTransform>(hand));
+		}
+
+		SECTION("Reparenting") {
+			set_parent(world, hand, other);
+			world.update(0.016f);
+
+			REQUIRE(world.get<Children>(arm) == nullptr);
+			REQUIRE(global(hand) == world.get<Transform>(hand)->to_mat4());
+
+			set_parent(world, hand, INVALID_ENTITY_ID);
+			REQUIRE(!world.has<Parent>(hand));
+		}
+
+		SECTION("Compaction") {
+			// Moves hand into the slot of root
+			world.despawn(root);
+			world.despawn(other);
+			world.update(0.016f);
+
+			// Links are translated by compact itself
+			const std::vector<EntityRemap> remap = world.compact();
+			REQUIRE(std::ranges::any_of(
+					remap, [&](const EntityRemap& entry) { return entry.from == hand; }));
+
+			for (const EntityRemap& entry : remap) {
+				if (entry.from == hand) {
+					hand = entry.to;
+				} else if (entry.from == arm) {
+					arm = entry.to;
+				}
+			}
+
+			REQUIRE(get_parent(world, hand) == arm);
+			REQUIRE(world.get<Children>(arm)->entities == std::vector<Entity>{ hand });
+
+			// Caches keyed by entity index must see relocated entities as changed
+			for (const EntityRemap& entry : remap) {
+				REQUIRE(world.is_changed<Transform>(entry.to));
+				REQUIRE(world.is_changed<GlobalTransform>(entry.to));
+			}
+
+			world.update(0.016f);
+
+			REQUIRE(global(arm) == world.get<Transform>(arm)->to_mat4());
+			REQUIRE(global(hand) == global(arm) * world.get<Transform>(hand)->to_mat4());
+
+			world.get<Transform>(arm)->position = Vec3f(0.0f, 5.0f, 0.0f);
+			world.mark_changed<Transform>(arm);
+			world.update(0.016f);
+
+			REQUIRE(global(arm) == world.get<Transform>(arm)->to_mat4());
+			REQUIRE(global(hand) == global(arm) * world.get<Transform>(hand)->to_mat4());
+		}
+
+		SECTION("Children follow interpolated parents") {
+			world.assign<PreviousTransform>(root)->transform = *world.get<Transform>(root);
+			world.get<Transform>(root)->position = Vec3f(3.0f, 0.0f, 0.0f);
+			world.mark_changed<Transform>(root);
+			world.update(0.016f);
+
+			TransformInterpolator interpolator;
+			interpolator.begin_frame(0.5f);
+
+			Mat4 blended_root;
+			REQUIRE(interpolator.resolve(world, root, blended_root));
+			REQUIRE(blended_root == Transform{ .position = Vec3f(2.0f, 0.0f, 0.0f) }.to_mat4());
+
+			Mat4 blended_hand;
+			REQUIRE(interpolator.resolve(world, hand, blended_hand));
+			REQUIRE(blended_hand == blended_root * world.get<Transform>(arm)->to_mat4() *
+							world.get<Transform>(hand)->to_mat4());
+
+			// Unrelated entities keep their GlobalTransform
+			Mat4 unused;
+			REQUIRE(!interpolator.resolve(world, other, unused));
+
+			// A full step renders exactly the current placement
+			interpolator.begin_frame(1.0f);
+			REQUIRE(interpolator.resolve(world, hand, blended_hand));
+			REQUIRE(blended_hand == global(hand));
+		}
+
+				SECTION("Despawning") {
+			world.despawn(arm);
+			world.update(0.016f);
+
+			// Orphans become roots
+			REQUIRE(global(hand) == world.get<Transform>(hand)->to_mat4());
+
+			set_parent(world, other, root);
+			set_parent(world, hand, other);
+			despawn_recursive(world, other);
+
+			REQUIRE(world.is_valid(root));
+			REQUIRE(!world.is_valid(other));
+			REQUIRE(!world.is_valid(hand));
+			REQUIRE(world.get<Children>(root) == nullptr);
+		}
+	}
+}
+
+TEST_CASE("Compaction translates links not made by set_parent", "[core]") {
+	Registry registry;
+
+	const Entity hole = registry.spawn();
+	Entity parent = registry.spawn();
+	Entity child = registry.spawn();
+
+	registry.assign<Parent>(child)->entity = parent;
+	registry.assign<Children>(parent)->entities.push_back(child);
+	registry.despawn(hole);
+
+	for (const EntityRemap& entry : registry.compact()) {
+		if (entry.from == child) {
+			child = entry.to;
+		} else if (entry.from == parent) {
+			parent = entry.to;
+		}
+	}
+
+	REQUIRE(get_parent(registry, child) == parent);
+	REQUIRE(registry.get<Children>(parent)->entities == std::vector<Entity>{ child });
+}
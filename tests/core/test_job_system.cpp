@@ -0,0 +1,354 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/entity_command_buffer.h"
+#include "core/job_system.h"
+#include "core/system.h"
+#include "core/transform.h"
+#include "core/world.h"
+
+using namespace gl;
+
+struct Counter {
+	int value = 0;
+};
+
+struct Position {
+	float x = 0.0f;
+};
+
+struct TestSystem : public System {
+	SystemAccess access;
+	std::function<void(Registry&)> fn;
+
+	TestSystem(SystemAccess p_access, std::function<void(Registry&)> p_fn) :
+			access(p_access), fn(std::move(p_fn)) {}
+
+	void on_update(Registry& registry, float dt) override { fn(registry); }
+
+	SystemAccess get_access() const override { return access; }
+};
+
+TEST_CASE("Job system parallel for", "[core]") {
+	JobSystem jobs(4);
+
+	REQUIRE(jobs.get_thread_count() == 4);
+
+	SECTION("Every index gets processed exactly once") {
+		std::vector<std::atomic_int> hits(10000);
+
+		jobs.parallel_for(hits.size(), 64, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) {
+				hits[i]++;
+			}
+		});
+
+		for (const auto& hit : hits) {
+			REQUIRE(hit.load() == 1);
+		}
+	}
+
+	SECTION("Ranges only depend on the chunk size") {
+		std::mutex mutex;
+		std::set<std::pair<uint32_t, uint32_t>> ranges;
+
+		jobs.parallel_for(10, 4, [&](uint32_t begin, uint32_t end) {
+			std::lock_guard<std::mutex> lock(mutex);
+			ranges.insert({ begin, end });
+		});
+
+		REQUIRE(ranges == std::set<std::pair<uint32_t, uint32_t>>{ { 0, 4 }, { 4, 8 }, { 8, 10 } });
+	}
+
+	SECTION("Nested parallel for") {
+		std::atomic_int total = 0;
+
+		jobs.parallel_for(8, 1, [&](uint32_t, uint32_t) {
+			jobs.parallel_for(100, 10, [&](uint32_t begin, uint32_t end) { total += end - begin; });
+		});
+
+		REQUIRE(total == 800);
+	}
+
+	SECTION("Exceptions reach the submitting thread") {
+		std::atomic_int processed = 0;
+
+		REQUIRE_THROWS_AS(jobs.parallel_for(100, 1,
+								  [&](uint32_t begin, uint32_t end) {
+									  processed++;
+									  if (begin == 42) {
+										  throw std::runtime_error("job failed");
+									  }
+								  }),
+				std::runtime_error);
+
+		// Every other job still ran before parallel_for returned
+		REQUIRE(processed == 100);
+	}
+}
+
+TEST_CASE("Registry parallel each", "[core]") {
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		World world(mode);
+		world.set_job_system(std::make_shared<JobSystem>(3));
+
+		std::vector<Entity> entities;
+		for (int i = 0; i < 5000; i++) {
+			Entity e = world.spawn();
+			world.assign<Counter>(e)->value = i;
+			entities.push_back(e);
+		}
+
+		world.par_each<Counter>([](Entity entity, Counter& counter) { counter.value *= 2; }, 100);
+
+		for (int i = 0; i < 5000; i++) {
+			REQUIRE(world.get<Counter>(entities[i])->value == i * 2);
+		}
+
+		world.group<Counter>().par_each(
+				[](Entity entity, Counter& counter) { counter.value += 1; }, 100);
+
+		for (int i = 0; i < 5000; i++) {
+			REQUIRE(world.get<Counter>(entities[i])->value == i * 2 + 1);
+		}
+
+		// Ranges crossing chunk and archetype boundaries
+		for (int i = 0; i < 5000; i += 3) {
+			world.assign<Position>(entities[i]);
+		}
+		world.par_each<Counter>([](Entity entity, Counter& counter) { counter.value -= 1; }, 37);
+
+		for (int i = 0; i < 5000; i++) {
+			REQUIRE(world.get<Counter>(entities[i])->value == i * 2);
+		}
+
+		// Only the written components are copied from a snapshot
+		{
+			Registry snapshot;
+			world.copy_to(snapshot);
+
+			const auto get_shared_pages = [&](uint32_t component_id) {
+				for (const ComponentMemoryStats& stats : world.get_memory_stats().components) {
+					if (stats.component_id == component_id) {
+						return stats.shared_pages;
+					}
+				}
+				return 0u;
+			};
+
+			const uint32_t shared = get_shared_pages(get_component_id<Counter>());
+			REQUIRE(shared > 0);
+
+			std::atomic<int64_t> sum = 0;
+			world.par_each<const Counter, Position>(
+					[&](Entity entity, const Counter& counter, Position& position) {
+						position.x = counter.value;
+						sum += counter.value;
+					},
+					100);
+			world.group<const Counter>().par_each(
+					[&](Entity entity, const Counter& counter) { sum += counter.value; }, 100);
+
+			// Every third entity has a position
+			int64_t expected = 0;
+			for (int i = 0; i < 5000; i++) {
+				expected += (i % 3 == 0 ? 4 : 2) * i;
+			}
+			REQUIRE(sum == expected);
+			REQUIRE(world.get<const Position>(entities[3])->x == 6.0f);
+			REQUIRE(snapshot.get<Position>(entities[3])->x == 0.0f);
+			// Archetype chunks hold both columns, writing one copies the chunk
+			if (mode == StorageMode::POOLED) {
+				REQUIRE(get_shared_pages(get_component_id<Counter>()) == shared);
+			}
+		}
+
+		// A single chunk spanning every entity runs inline
+		std::set<std::thread::id> threads;
+		const auto record_thread = [&](Entity entity, Counter& counter) {
+			threads.insert(std::this_thread::get_id());
+		};
+		world.par_each<Counter>(record_thread, entities.size());
+		REQUIRE(threads == std::set<std::thread::id>{ std::this_thread::get_id() });
+	}
+
+	// Worlds share one pool unless given their own
+	REQUIRE(World().get_job_system() == World().get_job_system());
+}
+
+TEST_CASE("System scheduling", "[core]") {
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		World world(mode);
+		world.set_job_system(std::make_shared<JobSystem>(2));
+
+		Entity entity = world.spawn();
+		world.assign<Counter>(entity);
+		world.assign<Position>(entity);
+
+		// Both systems of the first stage wait for each other, which only
+		// returns early if they really run at the same time
+		std::atomic_int arrived = 0;
+		std::atomic_bool concurrent = true;
+		const auto rendezvous = [&]() {
+			arrived++;
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+			while (arrived.load() < 2) {
+				if (std::chrono::steady_clock::now() > deadline) {
+					concurrent = false;
+					return;
+				}
+				std::this_thread::yield();
+			}
+		};
+
+		std::vector<std::string> order;
+		std::mutex order_mutex;
+		const auto log = [&](const char* name) {
+			std::lock_guard<std::mutex> lock(order_mutex);
+			order.push_back(name);
+		};
+
+		world.add_system(std::make_shared<TestSystem>(
+				SystemAccess().write<Counter>(), [&](Registry& registry) {
+					rendezvous();
+					registry.get<Counter>(entity)->value++;
+					registry.mark_changed<Counter>(entity);
+
+					EntityCommandBuffer& commands = registry.get_command_buffer();
+					commands.assign<Counter>(commands.spawn(), Counter{ 100 });
+					log("counter");
+				}));
+		world.add_system(std::make_shared<TestSystem>(
+				SystemAccess().write<Position>(), [&](Registry& registry) {
+					rendezvous();
+					registry.get<Position>(entity)->x += 1.0f;
+					log("position");
+				}));
+
+		int counters_seen = 0;
+		int changed_seen = 0;
+		world.add_system(std::make_shared<TestSystem>(
+				SystemAccess().read<Counter>(), [&](Registry& registry) {
+					counters_seen = 0;
+					registry.each<Counter>([&](Entity, Counter&) { counters_seen++; });
+
+					changed_seen = 0;
+					for (Entity changed : registry.view<Changed<Counter>>()) {
+						changed_seen++;
+					}
+					log("reader");
+				}));
+		world.add_system(std::make_shared<TestSystem>(
+				SystemAccess{ .exclusive = true }, [&](Registry& registry) {
+					// Exclusive systems may change the structure directly
+					registry.assign<Position>(registry.spawn());
+					log("exclusive");
+				}));
+		world.add_system(std::make_shared<TestSystem>(
+				SystemAccess().write<Position>(), [&](Registry&) { log("late"); }));
+
+		const std::vector<std::vector<uint32_t>> expected = { { 0, 1 }, { 2 }, { 3 }, { 4 } };
+		REQUIRE(world.get_schedule() == expected);
+
+		world.update(0.016f);
+
+		REQUIRE(concurrent);
+		REQUIRE(order.size() == 5);
+		REQUIRE(order[2] == "reader");
+		REQUIRE(order[3] == "exclusive");
+		REQUIRE(order[4] == "late");
+
+		// Deferred spawns are flushed before the next stage
+		REQUIRE(counters_seen == 2);
+
+		arrived = 0;
+		world.update(0.016f);
+
+		REQUIRE(concurrent);
+		REQUIRE(counters_seen == 3);
+		// The reader sees what the writer changed since its last run only
+		REQUIRE(changed_seen == 2);
+		REQUIRE(world.get<Counter>(entity)->value == 2);
+		REQUIRE(world.get<Position>(entity)->x == 2.0f);
+	}
+}
+
+TEST_CASE("Concurrent readers of a snapshot", "[core]") {
+	World world;
+	world.set_job_system(std::make_shared<JobSystem>(2));
+
+	for (int i = 0; i < 10000; i++) {
+		world.assign<Counter>(world.spawn())->value = i;
+	}
+
+	// Readers of the same component share a stage, the pages they read are
+	// shared with the snapshot until the stage detaches them
+	std::atomic_int64_t total = 0;
+	for (int i = 0; i < 2; i++) {
+		world.add_system(std::make_shared<TestSystem>(
+				SystemAccess().read<Counter>(), [&](Registry& registry) {
+					registry.each<Counter>(
+							[&](Entity, Counter& counter) { total += counter.value; });
+				}));
+	}
+	REQUIRE(world.get_schedule().size() == 1);
+
+	Registry snapshot;
+	world.copy_to(snapshot);
+
+	world.update(0.016f);
+
+	REQUIRE(total == 2 * (9999 * 10000 / 2));
+	REQUIRE(snapshot.count<Counter>() == 10000);
+}
+
+TEST_CASE("Fixed timestep", "[core]") {
+	World world;
+	world.set_fixed_timestep(0.01f, 4);
+
+	Entity entity = world.spawn();
+	world.assign<Transform>(entity);
+	world.assign<PreviousTransform>(entity);
+
+	int steps = 0;
+	world.add_fixed_system(std::make_shared<TestSystem>(
+			SystemAccess().write<Transform>(), [&](Registry& registry) {
+				registry.get<Transform>(entity)->position.x += 1.0f;
+				steps++;
+			}));
+
+	int frames = 0;
+	float alpha = 0.0f;
+	world.add_system(std::make_shared<TestSystem>(
+			SystemAccess().read<Transform, PreviousTransform>(), [&](Registry& registry) {
+				alpha = registry.get_interpolation_alpha();
+				frames++;
+			}));
+
+	REQUIRE(world.get_fixed_schedule() == std::vector<std::vector<uint32_t>>{ { 0 } });
+	REQUIRE(world.get_schedule() == std::vector<std::vector<uint32_t>>{ { 1 } });
+
+	// Less than a step only accumulates
+	world.update(0.004f);
+	REQUIRE(steps == 0);
+	REQUIRE(frames == 1);
+	REQUIRE(std::fabs(alpha - 0.4f) < 1e-4f);
+
+	world.update(0.021f);
+	REQUIRE(steps == 2);
+	REQUIRE(frames == 2);
+	REQUIRE(std::fabs(alpha - 0.5f) < 1e-4f);
+
+	const Transform& previous = world.get<PreviousTransform>(entity)->transform;
+	REQUIRE(previous.position.x == 1.0f);
+	REQUIRE(world.get<Transform>(entity)->position.x == 2.0f);
+	const Transform blended = interpolate(previous, *world.get<Transform>(entity), alpha);
+	REQUIRE(std::fabs(blended.position.x - 1.5f) < 1e-4f);
+
+	// A long frame is capped and the backlog dropped
+	world.update(1.0f);
+	REQUIRE(steps == 6);
+	REQUIRE(alpha < 1.0f);
+
+	world.update(0.01f);
+	REQUIRE(steps == 7);
+}
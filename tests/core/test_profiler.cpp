@@ -0,0 +1,195 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/profiler.h"
+#include "core/system.h"
+#include "core/world.h"
+
+using namespace gl;
+
+struct SleepSystem : public System {
+	void on_update(Registry& registry, float dt) override {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	std::string get_name() const override { return "SleepSystem"; }
+};
+
+struct UnnamedSystem : public System {};
+
+TEST_CASE("Profiler", "[core]") {
+	Profiler profiler;
+	const uint32_t track = profiler.add_track("track");
+
+	const Profiler::Clock::time_point start = Profiler::Clock::now();
+	const auto record_ms = [&](int ms) {
+		profiler.record(track, start, start + std::chrono::milliseconds(ms));
+	};
+
+	SECTION("Nothing is recorded while disabled") {
+		REQUIRE(!profiler.is_enabled());
+
+		record_ms(1);
+
+		REQUIRE(profiler.get_stats(track).sample_count == 0);
+	}
+
+	SECTION("Percentiles of the recorded durations") {
+		profiler.set_enabled(true);
+
+		// Out of order, stats must not depend on the recording order
+		for (int ms = 100; ms > 0; ms--) {
+			record_ms(ms);
+		}
+
+		const TimingStats stats = profiler.get_stats(track);
+		REQUIRE(stats.name == "track");
+		REQUIRE(stats.sample_count == 100);
+		REQUIRE(stats.last_ms == 1.0);
+		REQUIRE(stats.mean_ms == 50.5);
+		REQUIRE(stats.p50_ms == 50.0);
+		REQUIRE(stats.p95_ms == 95.0);
+		REQUIRE(stats.p99_ms == 99.0);
+		REQUIRE(stats.max_ms == 100.0);
+	}
+
+	SECTION("Only the latest samples are kept") {
+		profiler.set_enabled(true, 4);
+
+		for (int ms = 1; ms <= 10; ms++) {
+			record_ms(ms);
+		}
+
+		const TimingStats stats = profiler.get_stats(track);
+		REQUIRE(stats.sample_count == 4);
+		REQUIRE(stats.last_ms == 10.0);
+		REQUIRE(stats.p50_ms == 8.0);
+		REQUIRE(stats.max_ms == 10.0);
+
+		profiler.clear();
+		REQUIRE(profiler.get_stats(track).sample_count == 0);
+
+		record_ms(3);
+		REQUIRE(profiler.get_stats(track).sample_count == 1);
+		REQUIRE(profiler.get_stats(track).last_ms == 3.0);
+	}
+
+	SECTION("Chrome trace export") {
+		profiler.set_enabled(true);
+		profiler.add_track("quoted \"name\"");
+		record_ms(2);
+
+		const std::string trace = profiler.to_chrome_trace();
+		REQUIRE(trace.starts_with("{\"traceEvents\":["));
+		REQUIRE(trace.find("\"name\":\"track\"") != std::string::npos);
+		REQUIRE(trace.find("\"ph\":\"X\"") != std::string::npos);
+		REQUIRE(trace.find("\"dur\":2000.000") != std::string::npos);
+		// Tracks without samples don't produce events
+		REQUIRE(trace.find("quoted") == std::string::npos);
+	}
+}
+
+TEST_CASE("World profiling", "[core]") {
+	World world;
+	world.add_system(std::make_shared<SleepSystem>());
+	world.add_system(std::make_shared<UnnamedSystem>());
+
+	Profiler& profiler = world.get_profiler();
+	REQUIRE(profiler.get_track_count() == 3);
+
+	world.update(0.016f);
+	REQUIRE(profiler.get_stats(0).sample_count == 0);
+
+	profiler.set_enabled(true);
+	for (int i = 0; i < 3; i++) {
+		world.update(0.016f);
+	}
+
+	const std::vector<TimingStats> stats = profiler.get_all_stats();
+	REQUIRE(stats.size() == 3);
+
+	REQUIRE(stats[0].name == "frame");
+	REQUIRE(stats[0].sample_count == 3);
+	REQUIRE(stats[0].p50_ms >= 1.0);
+
+	REQUIRE(stats[1].name == "SleepSystem");
+	REQUIRE(stats[1].sample_count == 3);
+	REQUIRE(stats[1].p99_ms >= 1.0);
+	REQUIRE(stats[1].max_ms <= stats[0].max_ms);
+
+	// Demangled class name by default
+	REQUIRE(stats[2].name == "UnnamedSystem");
+	REQUIRE(stats[2].sample_count == 3);
+
+	const std::string trace = profiler.to_chrome_trace();
+	REQUIRE(trace.find("\"name\":\"SleepSystem\"") != std::string::npos);
+	REQUIRE(trace.find("\"name\":\"frame\"") != std::string::npos);
+}
+
+// Scopes are compiled out of distribution builds
+#ifndef GL_DIST_BUILD
+TEST_CASE("Scope tracing", "[core]") {
+	const fs::path path = fs::temp_directory_path() / "glsim_test_trace.json";
+
+	const auto read_trace = [&]() {
+		std::ifstream file(path);
+		return std::string(std::istreambuf_iterator<char>(file), {});
+	};
+
+	SECTION("Scopes of every thread end up in the trace") {
+		{ GL_PROFILE_SCOPE("before_start"); }
+
+		REQUIRE(Tracer::start(path.string()));
+		REQUIRE(Tracer::is_enabled());
+
+		{ GL_PROFILE_SCOPE("main_scope"); }
+		Tracer::flush();
+
+		std::thread([]() { GL_PROFILE_SCOPE("worker_scope"); }).join();
+
+		Tracer::stop();
+		REQUIRE(!Tracer::is_enabled());
+
+		{ GL_PROFILE_SCOPE("after_stop"); }
+
+		const std::string trace = read_trace();
+		REQUIRE(trace.starts_with("{\"traceEvents\":["));
+		REQUIRE(trace.ends_with("],\"displayTimeUnit\":\"ms\"}\n"));
+		REQUIRE(trace.find("\"name\":\"main_scope\"") != std::string::npos);
+		REQUIRE(trace.find("\"name\":\"worker_scope\"") != std::string::npos);
+		REQUIRE(trace.find("before_start") == std::string::npos);
+		REQUIRE(trace.find("after_stop") == std::string::npos);
+	}
+
+	SECTION("Buffers of exited threads are reused") {
+		REQUIRE(Tracer::start(path.string()));
+
+		std::thread([]() { GL_PROFILE_SCOPE("first_thread"); }).join();
+		Tracer::flush();
+		const size_t buffer_count = Tracer::get_buffer_count();
+
+		for (int i = 0; i < 8; i++) {
+			std::thread([]() { GL_PROFILE_SCOPE("thread"); }).join();
+			Tracer::flush();
+		}
+
+		REQUIRE(Tracer::get_buffer_count() == buffer_count);
+
+		Tracer::stop();
+		REQUIRE(read_trace().find("\"name\":\"first_thread\"") != std::string::npos);
+	}
+
+	SECTION("Events of a full buffer are dropped") {
+		REQUIRE(Tracer::start(path.string()));
+
+		for (uint32_t i = 0; i < Tracer::BUFFER_SIZE + 10; i++) {
+			GL_PROFILE_SCOPE("scope");
+		}
+
+		REQUIRE(Tracer::get_dropped_count() == 10);
+
+		Tracer::stop();
+	}
+
+	fs::remove(path);
+}
+#endif
@@ -1,5 +1,6 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include "core/component_registry.h"
 #include "core/registry.h"
 #include "core/transform.h"
 
@@ -217,3 +218,1080 @@ TEST_CASE("Registry views", "[core]") {
 		REQUIRE(it == view3.end());
 	}
 }
+
+TEST_CASE("Archetype storage", "[core]") {
+	Registry scene(StorageMode::ARCHETYPE);
+
+	Entity e1 = scene.spawn();
+	Entity e2 = scene.spawn();
+	Entity e3 = scene.spawn();
+
+	SECTION("Components survive archetype moves") {
+		TestComponent1* t1 = scene.assign<TestComponent1>(e1);
+		t1->a = 1;
+		t1->b = 2;
+		t1->c = 3;
+
+		// Moves e1 into the { TestComponent1, TestComponent2 } archetype
+		scene.assign<TestComponent2>(e1)->x = 4.0f;
+
+		REQUIRE(*scene.get<TestComponent1>(e1) == TestComponent1{ 1, 2, 3 });
+		REQUIRE(scene.get<TestComponent2>(e1)->x == 4.0f);
+
+		scene.remove<TestComponent2>(e1);
+
+		REQUIRE_FALSE(scene.has<TestComponent2>(e1));
+		REQUIRE(scene.get<TestComponent2>(e1) == nullptr);
+		REQUIRE(*scene.get<TestComponent1>(e1) == TestComponent1{ 1, 2, 3 });
+	}
+
+	SECTION("Despawn relocates the last row") {
+		scene.assign<TestComponent1>(e1)->a = 1;
+		scene.assign<TestComponent1>(e2)->a = 2;
+		scene.assign<TestComponent1>(e3)->a = 3;
+
+		scene.despawn(e1);
+
+		REQUIRE(scene.get<TestComponent1>(e2)->a == 2);
+		REQUIRE(scene.get<TestComponent1>(e3)->a == 3);
+	}
+
+	SECTION("Each streams matching archetypes") {
+		scene.assign_many<TestComponent1, TestComponent2>(e1);
+		scene.assign_many<TestComponent1, TestComponent2>(e2);
+		scene.assign<TestComponent1>(e3);
+
+		int count1 = 0;
+		scene.each<TestComponent1>([&](Entity entity, TestComponent1& t1) {
+			t1.a = get_entity_index(entity);
+			count1++;
+		});
+
+		int count2 = 0;
+		scene.each<TestComponent1, TestComponent2>(
+				[&](Entity entity, TestComponent1& t1, TestComponent2& t2) {
+					REQUIRE(t1.a == get_entity_index(entity));
+					count2++;
+				});
+
+		REQUIRE(count1 == 3);
+		REQUIRE(count2 == 2);
+	}
+
+	SECTION("Chunks fill up and release") {
+		std::vector<Entity> entities;
+		for (int i = 0; i < 2000; i++) {
+			Entity e = scene.spawn();
+			scene.assign<TestComponent1>(e)->a = i;
+			entities.push_back(e);
+		}
+
+		for (int i = 0; i < 2000; i += 2) {
+			scene.despawn(entities[i]);
+		}
+
+		for (int i = 1; i < 2000; i += 2) {
+			REQUIRE(scene.get<TestComponent1>(entities[i])->a == i);
+		}
+	}
+
+	SECTION("Copy") {
+		scene.assign<TestComponent1>(e1)->a = 7;
+
+		Registry copy;
+		scene.copy_to(copy);
+
+		REQUIRE(copy.get_storage_mode() == StorageMode::ARCHETYPE);
+		REQUIRE(copy.get<TestComponent1>(e1) != scene.get<TestComponent1>(e1));
+		REQUIRE(copy.get<TestComponent1>(e1)->a == 7);
+	}
+}
+
+TEST_CASE("Sparse set pools", "[core]") {
+	Registry scene;
+
+	std::vector<Entity> entities;
+	for (int i = 0; i < 100; i++) {
+		entities.push_back(scene.spawn());
+	}
+
+	SECTION("Removal keeps the remaining components intact") {
+		for (int i = 0; i < 100; i++) {
+			scene.assign<TestComponent1>(entities[i])->a = i;
+		}
+
+		scene.remove<TestComponent1>(entities[0]);
+		scene.despawn(entities[50]);
+
+		REQUIRE_FALSE(scene.has<TestComponent1>(entities[0]));
+		for (int i = 1; i < 100; i++) {
+			if (i != 50) {
+				REQUIRE(scene.get<TestComponent1>(entities[i])->a == i);
+			}
+		}
+	}
+
+	SECTION("Views are driven by the smallest pool") {
+		for (Entity e : entities) {
+			scene.assign<TestComponent1>(e);
+		}
+		scene.assign<TestComponent2>(entities[42]);
+		scene.assign<TestComponent2>(entities[7]);
+
+		std::vector<Entity> matched;
+		for (Entity e : scene.view<TestComponent1, TestComponent2>()) {
+			matched.push_back(e);
+		}
+
+		// Iteration follows the insertion order of the smallest pool
+		REQUIRE(matched == std::vector<Entity>{ entities[42], entities[7] });
+	}
+
+	SECTION("Views over unused components are empty") {
+		const auto view = scene.view<TestComponent2>();
+		REQUIRE(view.begin() == view.end());
+	}
+}
+
+TEST_CASE("Component masks", "[core]") {
+	ComponentMask a;
+	ComponentMask b;
+
+	REQUIRE(a.none());
+
+	a.set(3);
+	a.set(200);
+	b.set(200);
+
+	REQUIRE(a.any());
+	REQUIRE(a.test(200));
+	REQUIRE(a.contains(b));
+	REQUIRE_FALSE(b.contains(a));
+	REQUIRE((a & b) == b);
+
+	std::vector<uint32_t> bits;
+	a.for_each([&](uint32_t id) { bits.push_back(id); });
+	REQUIRE(bits == std::vector<uint32_t>{ 3, 200 });
+
+	a.reset(3);
+	REQUIRE(a == b);
+
+	// Bulk matching over a packed array, covering full batches and the tail
+	std::vector<ComponentMask> masks(37);
+	masks[5].set(200);
+	masks[20] = a;
+	masks[36].set(3);
+	masks[36].set(200);
+
+	masks[21] = a;
+
+	const auto scan_all = [&](size_t start, size_t count) {
+		std::vector<size_t> matches;
+		MaskScan scan(start);
+		for (size_t idx = scan.next(masks.data(), count, b); idx < count;
+				idx = scan.next(masks.data(), count, b)) {
+			matches.push_back(idx);
+		}
+		return matches;
+	};
+
+	REQUIRE(scan_all(0, masks.size()) == std::vector<size_t>{ 5, 20, 21, 36 });
+	REQUIRE(scan_all(6, masks.size()) == std::vector<size_t>{ 20, 21, 36 });
+	REQUIRE(scan_all(22, masks.size()) == std::vector<size_t>{ 36 });
+	REQUIRE(scan_all(37, masks.size()).empty());
+	REQUIRE(scan_all(0, 36) == std::vector<size_t>{ 5, 20, 21 });
+}
+
+TEST_CASE("Registry growth", "[core]") {
+	Registry scene;
+	scene.reserve(5000);
+	scene.reserve<TestComponent1>(5000);
+
+	TestComponent1* first = nullptr;
+	for (int i = 0; i < 5000; i++) {
+		Entity e = scene.spawn();
+		TestComponent1* t1 = scene.assign<TestComponent1>(e);
+		t1->a = i;
+
+		if (i == 0) {
+			first = t1;
+		}
+	}
+
+	// Component pointers stay valid while the pool grows
+	REQUIRE(first == scene.get<TestComponent1>(create_entity_id(0, 0)));
+	REQUIRE(first->a == 0);
+}
+
+struct LifetimeComponent {
+	std::shared_ptr<int> ref;
+	std::vector<int> values;
+};
+
+TEST_CASE("Component lifetime", "[core]") {
+	auto ref = std::make_shared<int>(0);
+
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		Registry scene(mode);
+
+		std::vector<Entity> entities;
+		for (int i = 0; i < 8; i++) {
+			Entity e = scene.spawn();
+			LifetimeComponent* lc = scene.assign<LifetimeComponent>(e);
+			lc->ref = ref;
+			lc->values = { i, i, i };
+			entities.push_back(e);
+		}
+
+		REQUIRE(ref.use_count() == 9);
+
+		// Removal destroys the component and relocates the last one
+		scene.remove<LifetimeComponent>(entities[0]);
+		scene.despawn(entities[1]);
+		REQUIRE(ref.use_count() == 7);
+		REQUIRE(scene.get<LifetimeComponent>(entities[7])->values == std::vector<int>{ 7, 7, 7 });
+
+		// Archetype moves must not leak or double free
+		scene.assign<TestComponent2>(entities[2]);
+		REQUIRE(ref.use_count() == 7);
+		REQUIRE(scene.get<LifetimeComponent>(entities[2])->values == std::vector<int>{ 2, 2, 2 });
+
+		// Reassigning replaces the existing component
+		scene.assign<LifetimeComponent>(entities[3]);
+		REQUIRE(ref.use_count() == 6);
+
+		{
+			Registry copy;
+			scene.copy_to(copy);
+
+			// Pool pages and archetype chunks are shared copy-on-write
+			REQUIRE(ref.use_count() == 6);
+		}
+		REQUIRE(ref.use_count() == 6);
+
+		scene.clear();
+		REQUIRE(ref.use_count() == 1);
+	}
+}
+
+TEST_CASE("Bulk operations", "[core]") {
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		Registry scene(mode);
+
+		// Leave a few free indices behind to be recycled
+		std::vector<Entity> old_entities(10);
+		scene.spawn_many(old_entities);
+		scene.despawn_many(std::span(old_entities).first(4));
+
+		std::vector<Entity> entities(1000);
+		scene.spawn_many(entities);
+
+		std::set<uint32_t> indices;
+		for (Entity entity : entities) {
+			REQUIRE(scene.is_valid(entity));
+			indices.insert(get_entity_index(entity));
+		}
+		REQUIRE(indices.size() == entities.size());
+
+		scene.assign_many_entities<TestComponent1>(entities, { 7, 1, 2 });
+		REQUIRE(scene.count<TestComponent1>() == 1000);
+
+		for (Entity entity : entities) {
+			REQUIRE(scene.get<TestComponent1>(entity)->a == 7);
+		}
+
+		scene.despawn_many(std::span(entities).first(500));
+		REQUIRE(scene.count<TestComponent1>() == 500);
+
+		for (uint32_t i = 0; i < entities.size(); i++) {
+			REQUIRE(scene.is_valid(entities[i]) == (i >= 500));
+		}
+
+		// Remaining components stay reachable, duplicates are despawned once
+		scene.query<TestComponent1>();
+		const std::vector<Entity> duplicates = { entities[600], entities[600], entities[999] };
+		scene.despawn_many(duplicates);
+		REQUIRE(scene.count<TestComponent1>() == 498);
+
+		uint32_t visited = 0;
+		scene.each<TestComponent1>([&](Entity entity, TestComponent1& t1) {
+			REQUIRE(scene.is_valid(entity));
+			REQUIRE(t1.a == 7);
+			visited++;
+		});
+		REQUIRE(visited == 498);
+
+		std::vector<Entity> respawned(3);
+		scene.spawn_many(respawned);
+		REQUIRE(respawned[0] != respawned[1]);
+		REQUIRE(respawned[1] != respawned[2]);
+	}
+}
+
+TEST_CASE("Cached queries", "[core]") {
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		Registry scene(mode);
+
+		Entity e1 = scene.spawn();
+		scene.assign_many<TestComponent1, TestComponent2>(e1);
+
+		Entity e2 = scene.spawn();
+		scene.assign<TestComponent1>(e2);
+
+		const auto collect = [&]() {
+			std::set<Entity> entities;
+			for (Entity entity : scene.query<TestComponent1, TestComponent2>()) {
+				entities.insert(entity);
+			}
+			return entities;
+		};
+
+		// Created from the existing entities on first use
+		REQUIRE(collect() == std::set<Entity>{ e1 });
+
+		scene.assign<TestComponent2>(e2);
+		REQUIRE(collect() == std::set<Entity>{ e1, e2 });
+
+		scene.remove<TestComponent2>(e1);
+		REQUIRE(collect() == std::set<Entity>{ e2 });
+
+		scene.despawn(e2);
+		REQUIRE(collect().empty());
+
+		// Recycled indices must not resurrect the old entity
+		Entity e3 = scene.spawn();
+		scene.assign_many<TestComponent1, TestComponent2>(e3);
+		REQUIRE(collect() == std::set<Entity>{ e3 });
+
+		uint32_t visited = 0;
+		scene.each<TestComponent1, TestComponent2>(
+				[&](Entity entity, TestComponent1&, TestComponent2&) { visited++; });
+		REQUIRE(visited == 1);
+
+		// Type-erased lookup shares the cached query
+		ComponentMask mask;
+		mask.set(get_component_id<TestComponent1>());
+		mask.set(get_component_id<TestComponent2>());
+		REQUIRE(scene.query(mask) == std::vector<Entity>{ e3 });
+
+		Registry copy;
+		scene.copy_to(copy);
+
+		uint32_t copied = 0;
+		for (Entity entity : copy.query<TestComponent1, TestComponent2>()) {
+			REQUIRE(entity == e3);
+			copied++;
+		}
+		REQUIRE(copied == 1);
+	}
+}
+
+TEST_CASE("Change detection", "[core]") {
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		Registry scene(mode);
+
+		const auto count = [](auto view) {
+			uint32_t result = 0;
+			for (Entity entity : view) {
+				result++;
+			}
+			return result;
+		};
+
+		Entity e1 = scene.spawn();
+		scene.assign_many<TestComponent1, TestComponent2>(e1);
+
+		Entity e2 = scene.spawn();
+		scene.assign_many<TestComponent1, TestComponent2>(e2);
+
+		REQUIRE(count(scene.view<Added<TestComponent1>>()) == 2);
+		REQUIRE(count(scene.query<Changed<TestComponent1>, TestComponent2>()) == 2);
+
+		// Next frame, nothing happened since
+		scene.set_last_change_tick(scene.get_change_tick());
+		scene.advance_change_tick();
+
+		REQUIRE(count(scene.view<Added<TestComponent1>>()) == 0);
+		REQUIRE(count(scene.view<Changed<TestComponent1>>()) == 0);
+		REQUIRE(!scene.is_changed<TestComponent1>(e1));
+
+		scene.mark_changed<TestComponent1>(e2);
+		REQUIRE(scene.is_changed<TestComponent1>(e2));
+		REQUIRE(!scene.is_added<TestComponent1>(e2));
+
+		for (Entity entity : scene.view<Changed<TestComponent1>, TestComponent2>()) {
+			REQUIRE(entity == e2);
+		}
+		REQUIRE(count(scene.query<Changed<TestComponent1>>()) == 1);
+		REQUIRE(count(scene.view<Changed<TestComponent2>>()) == 0);
+
+		scene.remove<TestComponent2>(e1);
+		scene.despawn(e2);
+
+		std::vector<Entity> removed = scene.get_removed<TestComponent2>();
+		std::sort(removed.begin(), removed.end());
+		REQUIRE(removed == std::vector<Entity>{ e1, e2 });
+
+		scene.trim_removed(scene.get_change_tick());
+		REQUIRE(scene.get_removed<TestComponent2>().empty());
+	}
+}
+
+TEST_CASE("Copy-on-write snapshots", "[core]") {
+	auto ref = std::make_shared<int>(0);
+
+	Registry scene;
+
+	std::vector<Entity> entities(3000);
+	scene.spawn_many(entities);
+
+	for (uint32_t i = 0; i < entities.size(); i++) {
+		scene.assign<TestComponent1>(entities[i])->a = i;
+		scene.assign<LifetimeComponent>(entities[i])->ref = ref;
+	}
+
+	{
+		Registry snapshot;
+		scene.copy_to(snapshot);
+
+		// Pages are shared until written to
+		REQUIRE(ref.use_count() == 3001);
+
+		// Reads leave them shared
+		REQUIRE(std::as_const(scene).get<LifetimeComponent>(entities[0])->ref == ref);
+		REQUIRE(scene.get<const LifetimeComponent>(entities[1])->ref == ref);
+		uint32_t count = 0;
+		scene.each<const LifetimeComponent>([&](Entity, const LifetimeComponent&) { count++; });
+		REQUIRE(count == 3000);
+		REQUIRE(ref.use_count() == 3001);
+
+		const auto get_shared_pages = [&]() {
+			for (const ComponentMemoryStats& stats : scene.get_memory_stats().components) {
+				if (stats.component_id == get_component_id<TestComponent1>()) {
+					return stats.shared_pages;
+				}
+			}
+			return 0u;
+		};
+
+		// Three pages each of sparse indices, components, entities and ticks.
+		// Removing moves the last component into the hole, only the pages
+		// written to get copied, which leaves the last entity page and the
+		// ticks shared.
+		REQUIRE(get_shared_pages() == 12);
+		scene.remove<TestComponent1>(entities[1]);
+		REQUIRE(get_shared_pages() == 7);
+
+		scene.get<TestComponent1>(entities[0])->a = -1;
+		scene.get<LifetimeComponent>(entities[2500])->values.push_back(1);
+
+		// Only the touched lifetime page got duplicated
+		const uint32_t last_page_count = 3000 - 2 * ComponentPool::PAGE_SIZE;
+		REQUIRE(ref.use_count() == 3001 + last_page_count);
+
+		scene.despawn(entities[1]);
+
+		REQUIRE(snapshot.get<TestComponent1>(entities[0])->a == 0);
+		REQUIRE(snapshot.get<LifetimeComponent>(entities[2500])->values.empty());
+		REQUIRE(snapshot.is_valid(entities[1]));
+		REQUIRE(snapshot.count<TestComponent1>() == 3000);
+
+		// Rolling back restores the snapshot
+		snapshot.copy_to(scene);
+		REQUIRE(scene.get<TestComponent1>(entities[0])->a == 0);
+		REQUIRE(scene.get<TestComponent1>(entities[1])->a == 1);
+	}
+
+	scene.clear();
+	REQUIRE(ref.use_count() == 1);
+}
+
+TEST_CASE("Copy-on-write archetype chunks", "[core]") {
+	Registry scene(StorageMode::ARCHETYPE);
+
+	std::vector<Entity> entities(3000);
+	scene.spawn_many(entities);
+	for (uint32_t i = 0; i < entities.size(); i++) {
+		scene.assign<TestComponent1>(entities[i])->a = i;
+	}
+
+	ComponentMask mask;
+	mask.set(get_component_id<TestComponent1>());
+	REQUIRE(scene.query(mask).size() == 3000);
+
+	Registry snapshot;
+	scene.copy_to(snapshot);
+
+	const auto get_stats = [&]() {
+		for (const ComponentMemoryStats& stats : scene.get_memory_stats().components) {
+			if (stats.component_id == get_component_id<TestComponent1>()) {
+				return stats;
+			}
+		}
+		return ComponentMemoryStats();
+	};
+
+	// Every chunk and the three tick pages are shared
+	const uint32_t chunk_count = get_stats().dense_pages;
+	REQUIRE(get_stats().shared_pages == chunk_count + 3);
+
+	// Reads leave them shared
+	REQUIRE(scene.get<const TestComponent1>(entities[0])->a == 0);
+	scene.each<const TestComponent1>([](Entity, const TestComponent1&) {});
+	REQUIRE(get_stats().shared_pages == chunk_count + 3);
+
+	// Writing copies the chunk and the tick page of the entity only
+	scene.get<TestComponent1>(entities[0])->a = -1;
+	scene.mark_changed<TestComponent1>(entities[0]);
+	REQUIRE(get_stats().shared_pages == chunk_count + 1);
+
+	// Queries are copied once an entity enters them
+	scene.assign<TestComponent1>(scene.spawn());
+	REQUIRE(scene.query(mask).size() == 3001);
+	REQUIRE(snapshot.query(mask).size() == 3000);
+
+	REQUIRE(snapshot.get<TestComponent1>(entities[0])->a == 0);
+	REQUIRE(scene.get<TestComponent1>(entities[1])->a == 1);
+}
+
+TEST_CASE("Owning groups", "[core]") {
+	Registry scene;
+
+	std::vector<Entity> entities(3000);
+	scene.spawn_many(entities);
+
+	// Every third entity owns both components
+	for (uint32_t i = 0; i < entities.size(); i++) {
+		scene.assign<TestComponent1>(entities[i])->a = i;
+		if (i % 3 == 0) {
+			scene.assign<TestComponent2>(entities[i])->x = i;
+		}
+	}
+
+	Group<TestComponent1, TestComponent2> group = scene.group<TestComponent1, TestComponent2>();
+	REQUIRE(group.get_size() == 1000);
+
+	const auto validate = [&]() {
+		uint32_t count = 0;
+		group.each([&](Entity entity, TestComponent1& t1, TestComponent2& t2) {
+			REQUIRE(&t1 == scene.get<TestComponent1>(entity));
+			REQUIRE(&t2 == scene.get<TestComponent2>(entity));
+			REQUIRE(t1.a == t2.x);
+			count++;
+		});
+		REQUIRE(count == group.get_size());
+	};
+
+	validate();
+
+	// Membership follows assign, remove and despawn
+	scene.assign<TestComponent2>(entities[1])->x = 1;
+	scene.remove<TestComponent2>(entities[0]);
+	scene.despawn(entities[3]);
+	scene.remove<TestComponent1>(entities[6]);
+	REQUIRE(group.get_size() == 998);
+	validate();
+
+	// Requesting the same group again returns the existing one
+	REQUIRE(scene.group<TestComponent1, TestComponent2>().get_size() == 998);
+
+	Registry copy;
+	scene.copy_to(copy);
+	REQUIRE(copy.group<TestComponent1, TestComponent2>().get_size() == 998);
+
+	// Only the components not owned yet are packed, the others are looked up
+	for (uint32_t i = 0; i < entities.size(); i += 2) {
+		if (scene.is_valid(entities[i])) {
+			scene.assign<Transform>(entities[i])->position.x = i;
+		}
+	}
+
+	Group<TestComponent1, Transform> partial = scene.group<TestComponent1, Transform>();
+	REQUIRE(partial.get_size() == 1499);
+	REQUIRE(scene.group<TestComponent2, TestComponent1>().get_size() == 998);
+
+	uint32_t partial_count = 0;
+	partial.each([&](Entity entity, TestComponent1& t1, Transform& transform) {
+		REQUIRE(&t1 == scene.get<TestComponent1>(entity));
+		REQUIRE(&transform == scene.get<Transform>(entity));
+		REQUIRE(transform.position.x == t1.a);
+		partial_count++;
+	});
+	REQUIRE(partial_count == 1499);
+
+	// Sorting an owned component reorders the members among themselves
+	scene.sort<Transform>([](const Transform& lhs, const Transform& rhs) {
+		return lhs.position.x > rhs.position.x;
+	});
+
+	float previous = entities.size();
+	partial.each([&](Entity entity, TestComponent1& t1, Transform& transform) {
+		REQUIRE(transform.position.x < previous);
+		REQUIRE(transform.position.x == t1.a);
+		previous = transform.position.x;
+	});
+
+	// The owning group is unaffected
+	validate();
+
+	// Handles outlive the groups of a cleared registry
+	scene.clear();
+	REQUIRE(group.get_size() == 0);
+	REQUIRE(partial.get_size() == 0);
+
+	const Entity entity = scene.spawn();
+	scene.assign<TestComponent1>(entity);
+	scene.assign<TestComponent2>(entity);
+	REQUIRE(group.get_size() == 1);
+}
+
+struct StaticTag {};
+
+struct BulkTag {};
+
+TEST_CASE("Tag components", "[core]") {
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		Registry scene(mode);
+
+		std::vector<Entity> entities(100);
+		scene.spawn_many(entities);
+
+		for (uint32_t i = 0; i < entities.size(); i++) {
+			scene.assign<TestComponent1>(entities[i])->a = i;
+			if (i % 4 == 0) {
+				REQUIRE(scene.assign<StaticTag>(entities[i]) != nullptr);
+			}
+		}
+
+		REQUIRE(scene.has<StaticTag>(entities[0]));
+		REQUIRE(scene.get<StaticTag>(entities[0]) != nullptr);
+		REQUIRE(scene.get<StaticTag>(entities[1]) == nullptr);
+		REQUIRE(scene.count<StaticTag>() == 25);
+		REQUIRE(scene.count<TestComponent1>() == 100);
+
+		const auto count = [](auto view) {
+			uint32_t result = 0;
+			for (Entity entity : view) {
+				result++;
+			}
+			return result;
+		};
+
+		REQUIRE(count(scene.view<StaticTag>()) == 25);
+		REQUIRE(count(scene.view<TestComponent1, StaticTag>()) == 25);
+		REQUIRE(count(scene.view<TestComponent1, Without<StaticTag>>()) == 75);
+		REQUIRE(count(scene.query<TestComponent1, Without<StaticTag>>()) == 75);
+		REQUIRE(count(scene.view<Without<StaticTag>>()) == 75);
+
+		uint32_t visited = 0;
+		scene.each<TestComponent1, StaticTag>([&](Entity entity, TestComponent1& t1, StaticTag&) {
+			REQUIRE(t1.a % 4 == 0);
+			visited++;
+		});
+		REQUIRE(visited == 25);
+
+		scene.remove<StaticTag>(entities[0]);
+		scene.despawn(entities[4]);
+		REQUIRE(count(scene.view<StaticTag>()) == 23);
+		REQUIRE(scene.get<TestComponent1>(entities[8])->a == 8);
+
+		// Bulk assigned tags stay mask only, also for the type-erased path
+		const uint32_t bulk_id = get_component_id<BulkTag>();
+		scene.assign_many_entities<BulkTag>(std::span(entities).subspan(10, 10));
+		REQUIRE(scene.assign(entities[50], bulk_id) == nullptr);
+		REQUIRE(scene.count<BulkTag>() == 11);
+		REQUIRE(scene.get(entities[50], bulk_id) == nullptr);
+		REQUIRE(scene.get<TestComponent1>(entities[12])->a == 12);
+
+		for (const ComponentMemoryStats& stats : scene.get_memory_stats().components) {
+			REQUIRE(stats.component_id != bulk_id);
+		}
+	}
+}
+
+TEST_CASE("Memory statistics", "[core]") {
+	const auto find_component = [](const MemoryStats& stats, uint32_t component_id) {
+		for (const ComponentMemoryStats& component : stats.components) {
+			if (component.component_id == component_id) {
+				return component;
+			}
+		}
+		return ComponentMemoryStats{};
+	};
+
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		Registry scene(mode);
+
+		std::vector<Entity> entities(ComponentPool::PAGE_SIZE);
+		scene.spawn_many(entities);
+
+		// A single component at the end of the first sparse page
+		scene.assign<TestComponent1>(entities.back());
+		scene.assign<StaticTag>(entities.back());
+		scene.despawn(entities[0]);
+
+		MemoryStats stats = scene.get_memory_stats();
+		REQUIRE(stats.entity_capacity == ComponentPool::PAGE_SIZE);
+		REQUIRE(stats.entity_count == ComponentPool::PAGE_SIZE - 1);
+		REQUIRE(stats.free_list_length == 1);
+		REQUIRE(stats.components.size() == 1);
+
+		ComponentMemoryStats component =
+				find_component(stats, get_component_id<TestComponent1>());
+		REQUIRE(component.count == 1);
+		REQUIRE(component.component_size == sizeof(TestComponent1));
+		REQUIRE(component.dense_pages == 1);
+		REQUIRE(component.bytes_used < component.bytes_reserved);
+		REQUIRE(component.get_fragmentation() > 0.9f);
+		REQUIRE(stats.get_bytes_used() <= stats.get_bytes_reserved());
+
+		if (mode == StorageMode::POOLED) {
+			REQUIRE(component.sparse_pages == 1);
+
+			Registry snapshot;
+			scene.copy_to(snapshot);
+			stats = scene.get_memory_stats();
+			component = find_component(stats, get_component_id<TestComponent1>());
+			// Sparse, dense, entity and tick page
+			REQUIRE(component.shared_pages == 4);
+		}
+	}
+}
+
+TEST_CASE("Registry compaction", "[core]") {
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		Registry scene(mode);
+
+		std::vector<Entity> entities(3000);
+		scene.spawn_many(entities);
+
+		for (uint32_t i = 0; i < entities.size(); i++) {
+			scene.assign<TestComponent1>(entities[i])->a = i;
+			if (i % 2 == 0) {
+				scene.assign<TestComponent2>(entities[i])->x = i;
+			}
+		}
+
+		uint32_t query_count = 0;
+		for (Entity entity : scene.query<TestComponent1, TestComponent2>()) {
+			query_count++;
+		}
+		REQUIRE(query_count == 1500);
+
+		// Churn the front of the table
+		std::vector<Entity> survivors;
+		for (uint32_t i = 0; i < entities.size(); i++) {
+			if (i < 2000 && i % 4 != 0) {
+				scene.despawn(entities[i]);
+			} else {
+				survivors.push_back(entities[i]);
+			}
+		}
+		scene.remove<TestComponent2>(entities[2998]);
+
+		const std::vector<EntityRemap> remap = scene.compact();
+
+		MemoryStats stats = scene.get_memory_stats();
+		REQUIRE(stats.entity_capacity == survivors.size());
+		REQUIRE(stats.free_list_length == 0);
+
+		std::unordered_map<Entity, Entity> lookup;
+		for (const EntityRemap& entry : remap) {
+			REQUIRE(!scene.is_valid(entry.from));
+			REQUIRE(scene.is_valid(entry.to));
+			REQUIRE(get_entity_index(entry.to) < survivors.size());
+			lookup[entry.from] = entry.to;
+		}
+
+		for (Entity entity : survivors) {
+			const uint32_t i = get_entity_index(entity);
+			if (lookup.contains(entity)) {
+				entity = lookup[entity];
+			}
+
+			REQUIRE(scene.get<TestComponent1>(entity)->a == i);
+			REQUIRE(scene.has<TestComponent2>(entity) == (i % 2 == 0 && i != 2998));
+		}
+
+		query_count = 0;
+		for (Entity entity : scene.query<TestComponent1, TestComponent2>()) {
+			REQUIRE(scene.get<TestComponent2>(entity)->x == scene.get<TestComponent1>(entity)->a);
+			query_count++;
+		}
+		REQUIRE(query_count == 500 + 499);
+
+		REQUIRE(scene.get_removed<TestComponent2>().back() == lookup[entities[2998]]);
+
+		// New slots never bring back ids of the truncated ones
+		std::vector<Entity> spawned(remap.size());
+		scene.spawn_many(spawned);
+		for (const EntityRemap& entry : remap) {
+			REQUIRE(!scene.is_valid(entry.from));
+		}
+	}
+}
+
+TEST_CASE("Component sorting", "[core]") {
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		Registry scene(mode);
+
+		std::vector<Entity> entities(2500);
+		scene.spawn_many(entities);
+
+		for (uint32_t i = 0; i < entities.size(); i++) {
+			scene.assign<TestComponent1>(entities[i])->a = (i * 7919) % entities.size();
+		}
+
+		Registry snapshot;
+		scene.copy_to(snapshot);
+
+		// Existing queries follow the new order, each uses this one
+		scene.query<TestComponent1>();
+
+		scene.sort<TestComponent1>(
+				[](const TestComponent1& lhs, const TestComponent1& rhs) { return lhs.a < rhs.a; });
+
+		int previous = -1;
+		scene.each<TestComponent1>([&](Entity entity, TestComponent1& t1) {
+			REQUIRE(t1.a > previous);
+			REQUIRE(t1.a == (get_entity_index(entity) * 7919) % entities.size());
+			previous = t1.a;
+		});
+		REQUIRE(previous == entities.size() - 1);
+
+		// The snapshot keeps its own order
+		REQUIRE(snapshot.get<TestComponent1>(entities[1])->a == 7919 % entities.size());
+
+		if (mode == StorageMode::POOLED) {
+			for (uint32_t i = 0; i < entities.size(); i += 2) {
+				const int a = scene.get<TestComponent1>(entities[i])->a;
+				scene.assign<TestComponent2>(entities[i])->x = a;
+			}
+
+			auto group = scene.group<TestComponent1, TestComponent2>();
+			scene.sort<TestComponent1>([](const TestComponent1& lhs, const TestComponent1& rhs) {
+				return lhs.a > rhs.a;
+			});
+
+			previous = entities.size();
+			group.each([&](Entity entity, TestComponent1& t1, TestComponent2& t2) {
+				REQUIRE(t1.a < previous);
+				REQUIRE(t2.x == t1.a);
+				previous = t1.a;
+			});
+
+			// Entities outside of the group are sorted behind it
+			previous = entities.size();
+			for (Entity entity : scene.view<TestComponent1, Without<TestComponent2>>()) {
+				REQUIRE(scene.get<TestComponent1>(entity)->a < previous);
+				previous = scene.get<TestComponent1>(entity)->a;
+			}
+		}
+	}
+}
+
+struct alignas(64) AlignedComponent {
+	std::string name;
+	int value;
+};
+
+TEST_CASE("Over-aligned components", "[core]") {
+	Registry scene;
+
+	std::vector<Entity> entities(1000);
+	scene.spawn_many(entities);
+
+	for (uint32_t i = 0; i < entities.size(); i++) {
+		AlignedComponent* component = scene.assign<AlignedComponent>(entities[i]);
+		component->value = entities.size() - i;
+		component->name = std::to_string(component->value);
+	}
+
+	// Moves components through the swap scratch, each follows the query order
+	scene.query<AlignedComponent>();
+	scene.sort<AlignedComponent>([](const AlignedComponent& lhs, const AlignedComponent& rhs) {
+		return lhs.value < rhs.value;
+	});
+
+	int previous = 0;
+	scene.each<AlignedComponent>([&](Entity entity, AlignedComponent& component) {
+		REQUIRE(reinterpret_cast<uintptr_t>(&component) % alignof(AlignedComponent) == 0);
+		REQUIRE(component.value == previous + 1);
+		REQUIRE(component.name == std::to_string(component.value));
+		previous = component.value;
+	});
+	REQUIRE(previous == entities.size());
+}
+
+TEST_CASE("Component registry", "[core]") {
+	const ComponentType& typed = ComponentRegistry::register_type<TestComponent1>("TestComponent1",
+			{ GL_FIELD(TestComponent1, a), GL_FIELD(TestComponent1, b),
+					GL_FIELD(TestComponent1, c) });
+
+	REQUIRE(typed.id == get_component_id<TestComponent1>());
+	REQUIRE(typed.hash == hash_component_name("TestComponent1"));
+	REQUIRE(typed.info.size == sizeof(TestComponent1));
+	REQUIRE(typed.find_field("b")->offset == offsetof(TestComponent1, b));
+	REQUIRE(typed.find_field("c")->type == FieldType::INT32);
+	REQUIRE(typed.find_field("d") == nullptr);
+
+	const ComponentType& runtime = ComponentRegistry::register_type("TestHealth",
+			{ { "alive", FieldType::BOOL }, { "hp", FieldType::FLOAT },
+					{ "position", FieldType::VEC3F } });
+
+	REQUIRE(runtime.id != typed.id);
+	REQUIRE(runtime.find_field("hp")->offset == 4);
+	REQUIRE(runtime.find_field("position")->offset == 8);
+	REQUIRE(runtime.info.size == 8 + sizeof(Vec3f));
+
+	// Registering a name again yields the existing type
+	REQUIRE(&ComponentRegistry::register_type("TestHealth", {}) == &runtime);
+	REQUIRE(ComponentRegistry::find("TestHealth") == &runtime);
+	REQUIRE(ComponentRegistry::find(runtime.hash) == &runtime);
+	REQUIRE(ComponentRegistry::get(runtime.id) == &runtime);
+	REQUIRE(ComponentRegistry::find("TestMissing") == nullptr);
+
+	const ComponentType& marker = ComponentRegistry::register_type("TestMarker", 0, 1);
+
+	const size_t hp_offset = runtime.find_field("hp")->offset;
+	const auto get_hp = [&](Registry& registry, Entity entity) {
+		float hp;
+		std::memcpy(&hp, static_cast<uint8_t*>(registry.get(entity, runtime.id)) + hp_offset,
+				sizeof(float));
+		return hp;
+	};
+
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		Registry registry(mode);
+
+		std::vector<Entity> entities(64);
+		registry.spawn_many(entities);
+
+		for (uint32_t i = 0; i < entities.size(); i++) {
+			registry.assign<TestComponent1>(entities[i])->a = i;
+
+			uint8_t* health = static_cast<uint8_t*>(registry.assign(entities[i], runtime.id));
+			REQUIRE(health != nullptr);
+			REQUIRE(health[0] == 0);
+
+			const float hp = i * 10.0f;
+			std::memcpy(health + hp_offset, &hp, sizeof(float));
+		}
+
+		REQUIRE(registry.assign(entities[0], marker.id) == nullptr);
+		REQUIRE(registry.has(entities[0], marker.id));
+		REQUIRE(registry.get(entities[0], marker.id) == nullptr);
+
+		registry.despawn(entities[3]);
+		registry.remove(entities[5], runtime.id);
+
+		REQUIRE(!registry.has(entities[5], runtime.id));
+		REQUIRE(registry.get(entities[5], runtime.id) == nullptr);
+
+		for (uint32_t i = 0; i < entities.size(); i++) {
+			if (i == 3 || i == 5) {
+				continue;
+			}
+
+			REQUIRE(get_hp(registry, entities[i]) == i * 10.0f);
+			REQUIRE(static_cast<TestComponent1*>(registry.get(entities[i], typed.id))->a == i);
+		}
+
+		registry.set_last_change_tick(registry.get_change_tick());
+		registry.advance_change_tick();
+		registry.mark_changed(entities[1], typed.id);
+		REQUIRE(registry.is_changed<TestComponent1>(entities[1]));
+		REQUIRE(!registry.is_changed<TestComponent1>(entities[2]));
+
+		Registry snapshot(mode);
+		registry.copy_to(snapshot);
+		REQUIRE(get_hp(snapshot, entities[7]) == 70.0f);
+	}
+}
+
+TEST_CASE("Component observers", "[core]") {
+	for (StorageMode mode : { StorageMode::POOLED, StorageMode::ARCHETYPE }) {
+		Registry registry(mode);
+
+		std::vector<std::vector<Entity>> added_batches;
+		std::vector<Entity> removed;
+
+		const uint32_t added_observer = registry.observe<TestComponent1>(
+				ObserverEvent::ADDED, [&](Registry&, std::span<const Entity> entities) {
+					for (Entity entity : entities) {
+						REQUIRE(registry.has<TestComponent1>(entity));
+					}
+					added_batches.emplace_back(entities.begin(), entities.end());
+				});
+		registry.observe<TestComponent1>(ObserverEvent::REMOVED,
+				[&](Registry&, std::span<const Entity> entities) {
+					removed.insert(removed.end(), entities.begin(), entities.end());
+				});
+
+		std::vector<Entity> entities(100);
+		registry.spawn_many(entities);
+		registry.assign_many_entities(std::span<const Entity>(entities), TestComponent1{});
+		registry.assign<TestComponent2>(entities[0]);
+
+		// Nothing is delivered before dispatching
+		REQUIRE(added_batches.empty());
+
+		// Replaced, and added then removed within the same frame
+		registry.assign<TestComponent1>(entities[1]);
+		registry.remove<TestComponent1>(entities[2]);
+
+		registry.dispatch_observers();
+
+		REQUIRE(added_batches.size() == 1);
+		REQUIRE(added_batches[0].size() == entities.size() - 1);
+		REQUIRE(std::is_sorted(added_batches[0].begin(), added_batches[0].end()));
+		REQUIRE(removed == std::vector<Entity>{ entities[2] });
+
+		registry.dispatch_observers();
+		REQUIRE(added_batches.size() == 1);
+
+		// Callbacks may raise new events, they are delivered in the same dispatch
+		registry.observe<TestComponent2>(ObserverEvent::REMOVED,
+				[&](Registry&, std::span<const Entity> entities) {
+					for (size_t i = 0; i < entities.size(); i++) {
+						registry.assign<TestComponent1>(registry.spawn());
+					}
+				});
+
+		registry.despawn(entities[0]);
+		registry.dispatch_observers();
+
+		REQUIRE(removed.size() == 2);
+		REQUIRE(removed[1] == entities[0]);
+		REQUIRE(added_batches.size() == 2);
+		REQUIRE(added_batches[1].size() == 1);
+
+		registry.unobserve(added_observer);
+		registry.assign<TestComponent1>(entities[2]);
+		registry.dispatch_observers();
+
+		REQUIRE(added_batches.size() == 2);
+
+		// Observers removing themselves and adding others while being called,
+		// the captured state has to outlive the call
+		auto calls = std::make_shared<uint32_t>(0);
+		uint32_t self_observer = 0;
+		self_observer = registry.observe<TestComponent2>(ObserverEvent::ADDED,
+				[&, calls](Registry&, std::span<const Entity>) {
+					registry.unobserve(self_observer);
+					for (uint32_t i = 0; i < 64; i++) {
+						registry.observe<TestComponent2>(
+								ObserverEvent::ADDED, [](Registry&, std::span<const Entity>) {});
+					}
+					(*calls)++;
+				});
+
+		registry.assign<TestComponent2>(entities[3]);
+		registry.dispatch_observers();
+		registry.assign<TestComponent2>(entities[4]);
+		registry.dispatch_observers();
+
+		REQUIRE(*calls == 1);
+		REQUIRE(calls.use_count() == 1);
+	}
+}
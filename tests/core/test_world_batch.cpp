@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/system.h"
+#include "core/transform.h"
+#include "core/world_batch.h"
+
+using namespace gl;
+
+struct Velocity {
+	Vec3f value;
+	int32_t bounces = 0;
+};
+
+class MoveSystem : public System {
+public:
+	void on_update(Registry& registry, float dt) override {
+		registry.each<Transform, Velocity>(
+				[&](Entity entity, Transform& transform, Velocity& velocity) {
+					transform.position += velocity.value * dt;
+					velocity.bounces++;
+				});
+		updates++;
+	}
+
+	SystemAccess get_access() const override {
+		return SystemAccess().read<Velocity>().write<Transform>();
+	}
+
+	int updates = 0;
+};
+
+TEST_CASE("World batch", "[core]") {
+	const ComponentType& velocity_type = ComponentRegistry::register_type<Velocity>("Velocity",
+			{ GL_FIELD(Velocity, value), GL_FIELD(Velocity, bounces) });
+
+	WorldBatch batch(16, StorageMode::POOLED, std::make_shared<JobSystem>(3));
+	REQUIRE(batch.get_world_count() == 16);
+
+	std::vector<std::shared_ptr<MoveSystem>> systems;
+	batch.add_system([&]() {
+		systems.push_back(std::make_shared<MoveSystem>());
+		return systems.back();
+	});
+	REQUIRE(systems.size() == 16);
+
+	// World i holds i % 3 moving entities and an observed-less one
+	for (uint32_t i = 0; i < batch.get_world_count(); i++) {
+		World& world = batch.get_world(i);
+		world.spawn();
+
+		for (uint32_t j = 0; j < i % 3; j++) {
+			Entity entity = world.spawn();
+			world.assign<Transform>(entity)->position = Vec3f(i, j, 0.0f);
+			world.assign<Velocity>(entity)->value = Vec3f(1.0f, 0.0f, 0.0f);
+		}
+	}
+
+	batch.set_observation({ { get_component_id<Transform>(), GL_FIELD(Transform, position) },
+								  { velocity_type.id, velocity_type.fields[1] } },
+			2);
+
+	REQUIRE(batch.get_observation_size() == 4);
+	REQUIRE(batch.get_observations().size() == 16 * 2 * 4);
+
+	batch.step(0.5f, 2);
+
+	for (const auto& system : systems) {
+		REQUIRE(system->updates == 2);
+	}
+
+	const std::span<const float> observations = batch.get_observations();
+	for (uint32_t i = 0; i < batch.get_world_count(); i++) {
+		REQUIRE(batch.get_observed_counts()[i] == i % 3);
+
+		for (uint32_t j = 0; j < 2; j++) {
+			const float* row = observations.data() + (i * 2 + j) * 4;
+			if (j < i % 3) {
+				REQUIRE(row[0] == i + 1.0f);
+				REQUIRE(row[1] == j);
+				REQUIRE(row[2] == 0.0f);
+				REQUIRE(row[3] == 2.0f);
+			} else {
+				REQUIRE(row[0] == 0.0f);
+				REQUIRE(row[3] == 0.0f);
+			}
+		}
+	}
+}